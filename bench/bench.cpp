@@ -0,0 +1,635 @@
+// Замеры производительности справочника. Собирается без системы сборки из корня репозитория:
+//
+//   g++ -std=c++17 -O2 -pthread -I transport-catalogue bench/bench.cpp $(ls transport-catalogue/*.cpp | grep -v main.cpp) -o tc_bench
+//
+// Входные файлы готовит bench/gen.py. Подкоманды:
+//   pipeline <input.json>                          загрузка, построение, карта и ответы на stat_requests
+//   distances [stops] [distances] [lookups]        таблица расстояний между остановками
+//   png <input.json> [repeats]                     карта в SVG и в PNG
+//   binary <input.json> [requests]                 запросы Stop и Bus в JSON и в двоичном протоколе
+//   builder [responses] [rides]                    построение ответов Route через json::Builder
+//   json <input.json> [repeats]                    json::Load и Print с ареной документа и без неё
+//   numbers [points] [repeats]                     json::Load и Print массива координат
+// Время - лучшее из повторов или по одному запуску, в миллисекундах
+
+#include "binary_protocol.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "metrics.h"
+#include "request_handler.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef TC_METRICS
+// Со сборкой -DTC_METRICS operator new считает metrics.cpp
+namespace {
+size_t allocation_count = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Через выровненный operator new память берёт std::pmr::new_delete_resource, а за ним
+// все арены и pmr-контейнеры JSON
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    ++allocation_count;
+    // Размер для aligned_alloc должен быть кратен выравниванию
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align + (size == 0 ? align : 0))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+namespace {
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+
+uint64_t GetAllocationCount() {
+#ifdef TC_METRICS
+    return metrics::GetAllocationCount();
+#else
+    return allocation_count;
+#endif
+}
+
+double ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+template <typename Action>
+double Measure(Action&& action) {
+    const auto start = Clock::now();
+    action();
+    return ToMilliseconds(Clock::now() - start);
+}
+
+// Пиковый объём резидентной памяти процесса в мегабайтах
+double GetPeakRssMb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+size_t ParseCount(int argc, char* argv[], int index, size_t default_value) {
+    return argc > index ? std::stoull(argv[index]) : default_value;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    std::ostringstream out;
+    out << file.rdbuf();
+    return out.str();
+}
+
+// Справочник, визуализатор и маршрутизатор, собранные из входного файла так же, как в main
+class City {
+public:
+    explicit City(const std::string& path)
+        : input_(ReadFile(path)) {
+        load_ms_ = Measure([this] {
+            reader_.emplace(input_);
+        });
+        // Запросы копируются до FillCatalogue, который забирает строки из base_requests
+        stat_requests_ = reader_->GetStatRequests();
+        fill_ms_ = Measure([this] {
+            reader_->FillCatalogue(catalogue_);
+        });
+        renderer_.emplace(reader_->SetRenderSettings(reader_->GetRenderSettings().AsDict()));
+        router_ms_ = Measure([this] {
+            router_.emplace(reader_->GetRouterSettings(reader_->GetRoutingSettings().AsDict()), catalogue_);
+        });
+        handler_.emplace(catalogue_, *renderer_, *router_);
+    }
+
+    JsonReader& GetReader() { return *reader_; }
+    const json::Node& GetStatRequests() const { return stat_requests_; }
+    const tc::TransportCatalogue& GetCatalogue() const { return catalogue_; }
+    const render::MapRenderer& GetRenderer() const { return *renderer_; }
+    const RequestHandler& GetHandler() const { return *handler_; }
+    // Время разбора JSON, заполнения справочника и построения маршрутизатора
+    double GetLoadMs() const { return load_ms_; }
+    double GetFillMs() const { return fill_ms_; }
+    double GetRouterMs() const { return router_ms_; }
+
+private:
+    double load_ms_ = 0;
+    double fill_ms_ = 0;
+    double router_ms_ = 0;
+    std::istringstream input_;
+    std::optional<JsonReader> reader_;
+    json::Node stat_requests_;
+    tc::TransportCatalogue catalogue_;
+    std::optional<render::MapRenderer> renderer_;
+    std::optional<tc::TransportRouter> router_;
+    std::optional<RequestHandler> handler_;
+};
+
+// Вид запроса для отчёта, как его различает JsonReader::ApplyRequests
+std::string GetRequestKind(const json::Dict& request) {
+    std::string type(request.at("type").AsString());
+    if (type != "Route") {
+        return type;
+    }
+    if (auto it = request.find("pareto"); it != request.end() && it->second.AsBool()) {
+        return "Route/pareto";
+    }
+    if (request.count("max_alternatives")) {
+        return "Route/alternatives";
+    }
+    if (request.count("departure_time")) {
+        return "Route/departure_time";
+    }
+    return type;
+}
+
+json::Node BuildResponse(const JsonReader& reader, const std::string& kind, const json::Dict& request,
+                         const RequestHandler& handler, std::pmr::memory_resource* resource) {
+    if (kind == "Stop") {
+        return reader.GetStopRequest(request, handler, resource);
+    }
+    if (kind == "Bus") {
+        return reader.GetBusRequest(request, handler, resource);
+    }
+    if (kind == "Isochrone") {
+        return reader.GetIsochroneRequest(request, handler, resource);
+    }
+    if (kind == "Matrix") {
+        return reader.GetMatrixRequest(request, handler, resource);
+    }
+    if (kind == "Route/pareto") {
+        return reader.GetParetoRouteRequest(request, handler, resource);
+    }
+    if (kind == "Route/alternatives") {
+        return reader.GetAlternativeRoutesRequest(request, handler, resource);
+    }
+    return reader.GetRouteRequest(request, handler, resource);
+}
+
+// Карта, как и в ApplyRequests, печатается в ответ по мере построения, без промежуточного узла
+void PrintResponse(const JsonReader& reader, const std::string& kind, const json::Dict& request,
+                   const RequestHandler& handler, std::pmr::memory_resource* resource, std::ostream& output) {
+    if (kind == "Map") {
+        reader.PrintMapResponse(request.at("id").AsInt(), handler, output);
+        return;
+    }
+    json::Print(json::Document{BuildResponse(reader, kind, request, handler, resource)}, output);
+}
+
+double Percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+// Каждый запрос отвечается и печатается отдельно, чтобы задержки считались по видам запросов.
+// Затем тот же пакет проходит через ApplyRequests с кэшем ответов, как в main, и пишет output.json
+int RunPipeline(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " pipeline <input.json>" << std::endl;
+        return 1;
+    }
+    City city(argv[2]);
+    const JsonReader& reader = city.GetReader();
+    const RequestHandler& handler = city.GetHandler();
+
+    std::ostringstream map_out;
+    const double render_ms = Measure([&city, &map_out] {
+        city.GetRenderer().RenderMap(city.GetCatalogue(), map_out);
+    });
+
+    std::map<std::string, std::vector<double>> latencies;
+    std::ostringstream output;
+    std::pmr::monotonic_buffer_resource arena;
+    const auto stat_start = Clock::now();
+    for (const auto& request : city.GetStatRequests().AsArray()) {
+        const json::Dict& request_dict = request.AsDict();
+        const std::string kind = GetRequestKind(request_dict);
+        const auto request_start = Clock::now();
+        PrintResponse(reader, kind, request_dict, handler, &arena, output);
+        latencies[kind].push_back(std::chrono::duration<double, std::micro>(Clock::now() - request_start).count());
+    }
+    const double stat_ms = ToMilliseconds(Clock::now() - stat_start);
+    const graph::RouteTreeCacheStats route_cache = handler.GetRouteCacheStats();
+    const double batch_ms = Measure([&city, &handler] {
+        city.GetReader().ApplyRequests(city.GetStatRequests(), handler);
+    });
+    const ResponseCacheStats response_cache = city.GetReader().GetResponseCacheStats();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "json load       " << city.GetLoadMs() << " ms\n"
+              << "fill catalogue  " << city.GetFillMs() << " ms\n"
+              << "build router    " << city.GetRouterMs() << " ms\n"
+              << "render map      " << render_ms << " ms, " << map_out.str().size() / 1024 << " KB\n"
+              << "stat requests   " << stat_ms << " ms, output " << output.str().size() / 1024 << " KB\n"
+              << "route cache     hits " << route_cache.hits << ", misses " << route_cache.misses
+              << ", evictions " << route_cache.evictions << '\n'
+              << "apply requests  " << batch_ms << " ms\n"
+              << "response cache  hits " << response_cache.hits << ", misses " << response_cache.misses
+              << ", evictions " << response_cache.evictions << ", " << response_cache.bytes / 1024 << " KB\n"
+              << "peak rss        " << GetPeakRssMb() << " MB\n\n"
+              << std::left << std::setw(22) << "request" << std::right << std::setw(8) << "count"
+              << std::setw(12) << "total ms" << std::setw(12) << "req/s" << std::setw(10) << "p50 us"
+              << std::setw(10) << "p90 us" << std::setw(10) << "p99 us" << std::setw(12) << "max us" << '\n';
+    for (auto& [kind, times] : latencies) {
+        std::sort(times.begin(), times.end());
+        double total_us = 0;
+        for (const double time : times) {
+            total_us += time;
+        }
+        std::cout << std::left << std::setw(22) << kind << std::right << std::setw(8) << times.size()
+                  << std::setw(12) << total_us / 1000 << std::setw(12) << times.size() / (total_us / 1e6)
+                  << std::setw(10) << Percentile(times, 0.5) << std::setw(10) << Percentile(times, 0.9)
+                  << std::setw(10) << Percentile(times, 0.99) << std::setw(12) << times.back() << '\n';
+    }
+    return 0;
+}
+
+// Прежняя таблица расстояний: std::unordered_map по паре указателей с хешем h1 + 100 * h2
+struct LegacyPtrHasher {
+    size_t operator()(const std::pair<const tc::Stop*, const tc::Stop*>& stops) const {
+        return hasher(stops.first) + 100 * hasher(stops.second);
+    }
+    std::hash<const tc::Stop*> hasher;
+};
+
+int RunDistances(int argc, char* argv[]) {
+    const size_t stop_count = std::max<size_t>(2, ParseCount(argc, argv, 2, 100'000));
+    const size_t distance_count = ParseCount(argc, argv, 3, 1'000'000);
+    const size_t lookup_count = ParseCount(argc, argv, 4, 1'000'000);
+
+    tc::TransportCatalogue catalogue;
+    std::vector<const tc::Stop*> stops;
+    stops.reserve(stop_count);
+    for (size_t i = 0; i < stop_count; ++i) {
+        stops.push_back(catalogue.AddStop("Stop "s + std::to_string(i), {55.0 + i * 1e-5, 37.0}));
+    }
+    // Пары соседних по номеру остановок, как у остановок одного маршрута
+    std::mt19937_64 random(1);
+    std::vector<std::pair<const tc::Stop*, const tc::Stop*>> pairs;
+    pairs.reserve(distance_count);
+    for (size_t i = 0; i < distance_count; ++i) {
+        const size_t from = random() % stop_count;
+        pairs.emplace_back(stops[from], stops[(from + 1 + random() % 50) % stop_count]);
+    }
+    std::vector<size_t> lookups(lookup_count);
+    for (size_t& lookup : lookups) {
+        lookup = random() % pairs.size();
+    }
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        catalogue.SetDistanceToStops(pairs[i].first, pairs[i].second, static_cast<int>(i % 10'000) + 1);
+    }
+    const double insert_ms = ToMilliseconds(Clock::now() - start);
+    long long checksum = 0;
+    start = Clock::now();
+    for (const size_t lookup : lookups) {
+        checksum += catalogue.GetDistanceBetweenStops(pairs[lookup].first, pairs[lookup].second);
+    }
+    const double lookup_ms = ToMilliseconds(Clock::now() - start);
+
+    std::unordered_map<std::pair<const tc::Stop*, const tc::Stop*>, int, LegacyPtrHasher> legacy;
+    start = Clock::now();
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        legacy[pairs[i]] = static_cast<int>(i % 10'000) + 1;
+    }
+    const double legacy_insert_ms = ToMilliseconds(Clock::now() - start);
+    long long legacy_checksum = 0;
+    start = Clock::now();
+    for (const size_t lookup : lookups) {
+        legacy_checksum += legacy.at(pairs[lookup]);
+    }
+    const double legacy_lookup_ms = ToMilliseconds(Clock::now() - start);
+    size_t longest_bucket = 0;
+    for (size_t bucket = 0; bucket < legacy.bucket_count(); ++bucket) {
+        longest_bucket = std::max(longest_bucket, legacy.bucket_size(bucket));
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << stop_count << " stops, " << distance_count << " distances, " << lookup_count << " lookups\n"
+              << "catalogue  insert " << insert_ms << " ms, lookups " << lookup_count / lookup_ms / 1000 << " M/s\n"
+              << "legacy     insert " << legacy_insert_ms << " ms, lookups " << lookup_count / legacy_lookup_ms / 1000
+              << " M/s, longest bucket " << longest_bucket << '\n';
+    if (checksum != legacy_checksum) {
+        std::cerr << "Checksum mismatch: " << checksum << " != " << legacy_checksum << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+template <typename Render>
+std::pair<double, size_t> MeasureBest(size_t repeats, Render&& render) {
+    double best_ms = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < repeats; ++i) {
+        std::ostringstream out;
+        const auto start = Clock::now();
+        render(out);
+        const double ms = ToMilliseconds(Clock::now() - start);
+        best_ms = i == 0 ? ms : std::min(best_ms, ms);
+        size = out.str().size();
+    }
+    return {best_ms, size};
+}
+
+int RunPng(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " png <input.json> [repeats]" << std::endl;
+        return 1;
+    }
+    const City city(argv[2]);
+    const size_t repeats = std::max<size_t>(1, ParseCount(argc, argv, 3, 3));
+    const auto [svg_ms, svg_size] = MeasureBest(repeats, [&city](std::ostream& out) {
+        city.GetRenderer().RenderMap(city.GetCatalogue(), out);
+    });
+    const auto [png_ms, png_size] = MeasureBest(repeats, [&city](std::ostream& out) {
+        city.GetRenderer().RenderMapPng(city.GetCatalogue(), out);
+    });
+    std::cout << std::fixed << std::setprecision(1) << "best of " << repeats << '\n'
+              << "svg " << svg_ms << " ms, " << svg_size / 1024 << " KB\n"
+              << "png " << png_ms << " ms, " << png_size / 1024 << " KB\n";
+    return 0;
+}
+
+// Одни и те же случайные запросы Stop и Bus отвечаются через JSON и через двоичный протокол.
+// Время включает разбор запросов и печать ответов, но не загрузку справочника
+int RunBinary(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " binary <input.json> [requests]" << std::endl;
+        return 1;
+    }
+    City city(argv[2]);
+    const size_t request_count = ParseCount(argc, argv, 3, 300'000);
+    const RequestHandler& handler = city.GetHandler();
+    const std::vector<std::string_view> stop_names = handler.GetStopNamesById();
+    const std::vector<std::string_view> bus_names = handler.GetSortedBusNames();
+    if (stop_names.empty() || bus_names.empty()) {
+        std::cerr << "The input needs at least one stop and one bus" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 random(1);
+    json::Builder json_requests;
+    json_requests.StartArray();
+    std::string binary_requests;
+    std::string frame;
+    frame.push_back(static_cast<char>(binary::MessageType::HELLO));
+    binary::WriteVarint(frame, binary::PROTOCOL_VERSION);
+    binary::WriteVarint(binary_requests, frame.size());
+    binary_requests += frame;
+    for (size_t id = 0; id < request_count; ++id) {
+        const bool is_stop = random() % 2 == 0;
+        const uint64_t index = is_stop ? random() % stop_names.size() : random() % bus_names.size();
+        json_requests.StartDict()
+            .Key("id").Value(static_cast<int>(id))
+            .Key("type").Value(is_stop ? "Stop"s : "Bus"s)
+            .Key("name").Value(std::string(is_stop ? stop_names[index] : bus_names[index]))
+            .EndDict();
+        frame.clear();
+        frame.push_back(static_cast<char>(is_stop ? binary::MessageType::STOP : binary::MessageType::BUS));
+        binary::WriteVarint(frame, id);
+        binary::WriteVarint(frame, index);
+        binary::WriteVarint(binary_requests, frame.size());
+        binary_requests += frame;
+    }
+    std::ostringstream json_text;
+    json::Print(json_requests.EndArray().Build(), json_text, 0);
+    const std::string json_input = json_text.str();
+
+    auto start = Clock::now();
+    std::istringstream json_in(json_input);
+    const json::Document requests = json::Load(json_in);
+    std::ostringstream json_out;
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        json::Builder responses(&arena);
+        responses.StartArray();
+        const JsonReader& reader = city.GetReader();
+        for (const auto& request : requests.GetRoot().AsArray()) {
+            const json::Dict& request_dict = request.AsDict();
+            json::Node response = request_dict.at("type").AsString() == "Stop"sv
+                                ? reader.GetStopRequest(request_dict, handler, &arena)
+                                : reader.GetBusRequest(request_dict, handler, &arena);
+            responses.Value(std::move(response.GetValue()));
+        }
+        json::Print(responses.EndArray().Build(), json_out, 4);
+    }
+    const double json_ms = ToMilliseconds(Clock::now() - start);
+
+    start = Clock::now();
+    std::istringstream binary_in(binary_requests);
+    std::ostringstream binary_out;
+    binary::Server(handler).Serve(binary_in, binary_out, false);
+    const double binary_ms = ToMilliseconds(Clock::now() - start);
+
+    std::cout << std::fixed << std::setprecision(1) << request_count << " Stop/Bus requests\n"
+              << "json   " << json_ms << " ms, " << std::setprecision(0) << request_count / json_ms * 1000 << " req/s, in "
+              << json_input.size() / 1024 << " KB, out " << json_out.str().size() / 1024 << " KB\n"
+              << "binary " << std::setprecision(1) << binary_ms << " ms, " << std::setprecision(0) << request_count / binary_ms * 1000 << " req/s, in "
+              << binary_requests.size() / 1024 << " KB, out " << binary_out.str().size() / 1024 << " KB\n";
+    return 0;
+}
+
+// Ответы Route собираются в арену, как в ApplyRequests; считаются выделения в куче сверх арены
+int RunBuilder(int argc, char* argv[]) {
+    const size_t response_count = std::max<size_t>(1, ParseCount(argc, argv, 2, 2000));
+    const size_t ride_count = ParseCount(argc, argv, 3, 200);
+    std::istringstream empty_input("{}");
+    const JsonReader reader(empty_input);
+    std::vector<tc::RouterEdge> rides;
+    for (size_t i = 0; i < ride_count; ++i) {
+        rides.push_back({"Bus "s + std::to_string(i % 37), "Stop number "s + std::to_string(i),
+                         "Stop number "s + std::to_string(i + 1), 3, 7.5, 2.0});
+    }
+    const std::optional<std::vector<tc::RouterEdge>> route = std::move(rides);
+
+    double best_ms = 0;
+    uint64_t allocations = 0;
+    for (int repeat = 0; repeat < 5; ++repeat) {
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<json::Node> responses;
+        responses.reserve(response_count);
+        const uint64_t allocations_before = GetAllocationCount();
+        const auto start = Clock::now();
+        for (size_t id = 0; id < response_count; ++id) {
+            responses.push_back(reader.GetRouteResponse(static_cast<int>(id), route, &arena));
+        }
+        const double ms = ToMilliseconds(Clock::now() - start);
+        allocations = GetAllocationCount() - allocations_before;
+        best_ms = repeat == 0 ? ms : std::min(best_ms, ms);
+    }
+    // Выделения монотонной арены под свои блоки тоже идут через operator new
+    std::cout << std::fixed << std::setprecision(1) << response_count << " Route responses of "
+              << ride_count << " rides\n"
+              << "build " << best_ms << " ms, heap allocations per response "
+              << static_cast<double>(allocations) / response_count << '\n';
+    return 0;
+}
+
+struct JsonTimings {
+    double load_ms = 0;
+    double free_ms = 0;
+    double print_ms = 0;
+    uint64_t load_allocations = 0;
+    uint64_t print_allocations = 0;
+    std::string output;
+};
+
+// Лучшее из repeats время загрузки text, освобождения документа и его печати. Без арены
+// узлы берутся из new_delete_resource, как до размещения документа в арене
+JsonTimings MeasureJson(const std::string& text, size_t repeats, bool use_arena) {
+    JsonTimings best;
+    for (size_t repeat = 0; repeat < repeats; ++repeat) {
+        JsonTimings timings;
+        std::istringstream input(text);
+        std::optional<json::Document> document;
+        uint64_t allocations_before = GetAllocationCount();
+        timings.load_ms = Measure([&] {
+            document.emplace(use_arena ? json::Load(input) : json::Load(input, std::pmr::new_delete_resource()));
+        });
+        timings.load_allocations = GetAllocationCount() - allocations_before;
+        std::ostringstream output;
+        allocations_before = GetAllocationCount();
+        timings.print_ms = Measure([&] {
+            json::Print(*document, output);
+        });
+        timings.print_allocations = GetAllocationCount() - allocations_before;
+        timings.free_ms = Measure([&document] {
+            document.reset();
+        });
+        timings.output = output.str();
+        if (repeat > 0) {
+            timings.load_ms = std::min(timings.load_ms, best.load_ms);
+            timings.free_ms = std::min(timings.free_ms, best.free_ms);
+            timings.print_ms = std::min(timings.print_ms, best.print_ms);
+        }
+        best = std::move(timings);
+    }
+    return best;
+}
+
+double ToMegabytesPerSecond(size_t size, double ms) {
+    return size / ms / 1000;
+}
+
+int RunJson(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " json <input.json> [repeats]" << std::endl;
+        return 1;
+    }
+    const std::string text = ReadFile(argv[2]);
+    const size_t repeats = std::max<size_t>(1, ParseCount(argc, argv, 3, 3));
+    const JsonTimings arena = MeasureJson(text, repeats, true);
+    const JsonTimings heap = MeasureJson(text, repeats, false);
+    std::cout << std::fixed << std::setprecision(1) << text.size() / 1024 << " KB, best of " << repeats << '\n';
+    for (const auto& [name, timings] : {std::pair{"arena", &arena}, std::pair{"heap ", &heap}}) {
+        std::cout << name << " load " << timings->load_ms << " ms, "
+                  << ToMegabytesPerSecond(text.size(), timings->load_ms) << " MB/s, "
+                  << timings->load_allocations << " allocations; free " << timings->free_ms << " ms; print "
+                  << timings->print_ms << " ms, " << ToMegabytesPerSecond(timings->output.size(), timings->print_ms)
+                  << " MB/s, " << timings->print_allocations << " allocations\n";
+    }
+    if (arena.output != heap.output) {
+        std::cerr << "printed documents differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Массив пар [широта, долгота] с полной точностью, как координаты остановок во входных файлах
+int RunNumbers(int argc, char* argv[]) {
+    const size_t point_count = ParseCount(argc, argv, 2, 1'000'000);
+    const size_t repeats = std::max<size_t>(1, ParseCount(argc, argv, 3, 3));
+    std::mt19937_64 random(1);
+    std::uniform_real_distribution<double> offset(0, 0.5);
+    std::ostringstream text;
+    text << std::setprecision(17) << '[';
+    for (size_t i = 0; i < point_count; ++i) {
+        text << (i == 0 ? "" : ",") << '[' << 55.5 + offset(random) << ',' << 37.3 + offset(random) << ']';
+    }
+    text << ']';
+    const JsonTimings timings = MeasureJson(text.str(), repeats, true);
+    std::cout << std::fixed << std::setprecision(1) << point_count << " points, " << text.str().size() / 1024
+              << " KB in, " << timings.output.size() / 1024 << " KB out, best of " << repeats << '\n'
+              << "load  " << timings.load_ms << " ms, " << ToMegabytesPerSecond(text.str().size(), timings.load_ms)
+              << " MB/s\n"
+              << "print " << timings.print_ms << " ms, "
+              << ToMegabytesPerSecond(timings.output.size(), timings.print_ms) << " MB/s\n";
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string_view command = argc > 1 ? argv[1] : "";
+    try {
+        if (command == "pipeline") {
+            return RunPipeline(argc, argv);
+        }
+        if (command == "distances") {
+            return RunDistances(argc, argv);
+        }
+        if (command == "png") {
+            return RunPng(argc, argv);
+        }
+        if (command == "binary") {
+            return RunBinary(argc, argv);
+        }
+        if (command == "builder") {
+            return RunBuilder(argc, argv);
+        }
+        if (command == "json") {
+            return RunJson(argc, argv);
+        }
+        if (command == "numbers") {
+            return RunNumbers(argc, argv);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "Usage: " << argv[0] << " pipeline|distances|png|binary|builder|json|numbers ..." << std::endl;
+    return 1;
+}
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Генератор синтетических городов для замеров производительности.
+
+Остановки равномерно разбросаны по квадрату с заданной плотностью, маршруты идут
+между соседними остановками и чаще проходят через пересадочные узлы. Расстояния по
+дорогам задаются для каждой пары соседних остановок маршрута хотя бы в одну сторону.
+
+Пример:
+    python3 bench/gen.py --stops 1500 --buses 400 --requests 2000 \\
+        --mix Stop=2,Bus=2,Route=6 --seed 1 -o input.json
+"""
+
+import argparse
+import json
+import math
+import random
+import sys
+
+REQUEST_TYPES = ("Stop", "Bus", "Route", "Map", "Matrix",
+                 "Isochrone", "Timetable", "Pareto",
+                 "Alternatives")
+
+# Слоги для длинных имён остановок в UTF-8, как в реальных справочниках
+SYLLABLES = ("Мор", "ской", "Во", "кзал", "Уни", "вер", "сам", "Бир", "ю", "лё",
+             "во", "Пра", "жская", "Ту", "ти", "ки", "Ра", "ду", "жная")
+
+EARTH_RADIUS = 6371000
+
+
+def parse_mix(text):
+    weights = {}
+    for item in text.split(","):
+        name, _, weight = item.partition("=")
+        if name not in REQUEST_TYPES:
+            raise SystemExit(f"unknown request type in --mix: {name}")
+        weights[name] = float(weight or 1)
+    return weights
+
+
+def make_names(count, style, rng):
+    if style == "ascii":
+        return [f"Stop {i}" for i in range(count)]
+    names = []
+    for i in range(count):
+        word = "".join(rng.choice(SYLLABLES) for _ in range(rng.randint(2, 4)))
+        names.append(f"{word} {i}")
+    return names
+
+
+def distance(a, b):
+    lat1, lon1 = map(math.radians, a)
+    lat2, lon2 = map(math.radians, b)
+    cos = (math.sin(lat1) * math.sin(lat2)
+           + math.cos(lat1) * math.cos(lat2) * math.cos(abs(lon1 - lon2)))
+    return math.acos(max(-1.0, min(1.0, cos))) * EARTH_RADIUS
+
+
+class Grid:
+    """Сетка ячеек для поиска ближайших остановок без перебора всех."""
+
+    def __init__(self, coords, cell):
+        self.coords = coords
+        self.cell = cell
+        self.cells = {}
+        for index, (lat, lon) in enumerate(coords):
+            self.cells.setdefault(self.key(lat, lon), []).append(index)
+
+    def key(self, lat, lon):
+        return int(lat / self.cell), int(lon / self.cell)
+
+    def nearest(self, index, count):
+        lat, lon = self.coords[index]
+        cx, cy = self.key(lat, lon)
+        found = []
+        radius = 1
+        while len(found) <= count and radius < 64:
+            found = [other
+                     for x in range(cx - radius, cx + radius + 1)
+                     for y in range(cy - radius, cy + radius + 1)
+                     for other in self.cells.get((x, y), ())
+                     if other != index]
+            radius += 1
+        found.sort(key=lambda other: (self.coords[other][0] - lat) ** 2
+                   + (self.coords[other][1] - lon) ** 2)
+        return found[:count]
+
+
+def make_route(start, length, grid, is_hub, transfer_density, rng):
+    route = [start]
+    visited = {start}
+    while len(route) < length:
+        candidates = [stop for stop in grid.nearest(route[-1], 8) if stop not in visited]
+        if not candidates:
+            break
+        weights = [1 + 10 * transfer_density if is_hub[stop] else 1 for stop in candidates]
+        stop = rng.choices(candidates, weights)[0]
+        route.append(stop)
+        visited.add(stop)
+    return route
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--stops", type=int, default=1000)
+    parser.add_argument("--buses", type=int, default=200)
+    parser.add_argument("--min-route", type=int, default=5,
+                        help="наименьшее число остановок маршрута")
+    parser.add_argument("--max-route", type=int, default=20,
+                        help="наибольшее число остановок маршрута")
+    parser.add_argument("--roundtrip", type=float, default=0.5,
+                        help="доля кольцевых маршрутов")
+    parser.add_argument("--hubs", type=float, default=0.05,
+                        help="доля остановок, которые служат пересадочными узлами")
+    parser.add_argument("--transfer-density", type=float, default=0.5,
+                        help="насколько охотнее маршруты проходят через узлы, от 0 до 1")
+    parser.add_argument("--distance-coverage", type=float, default=0.5,
+                        help="доля пар соседних остановок с расстоянием в обе стороны")
+    parser.add_argument("--schedules", type=float, default=0.0,
+                        help="доля маршрутов с расписанием отправлений")
+    parser.add_argument("--names", choices=("ascii", "utf8"), default="ascii")
+    parser.add_argument("--requests", type=int, default=1000)
+    parser.add_argument("--mix", default="Stop=1,Bus=1,Route=2",
+                        help="веса видов запросов: " + ", ".join(REQUEST_TYPES))
+    parser.add_argument("--format", choices=("svg", "png"), default="svg")
+    parser.add_argument("--lod-tolerance", type=float, default=0,
+                        help="допуск упрощения обзорной карты в пикселях")
+    parser.add_argument("--width", type=int, default=1200)
+    parser.add_argument("--height", type=int, default=1200)
+    parser.add_argument("--route-cache-mb", type=float, default=0,
+                        help="кэш деревьев маршрутов вместо таблицы всех пар")
+    parser.add_argument("--compression", choices=("none", "gzip"), default="none",
+                        help="сжатие output.json и map.svg")
+    parser.add_argument("--map-files", action="store_true",
+                        help="карта из ответа на запрос Map пишется в отдельный файл")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("-o", "--output", default="-")
+    args = parser.parse_args()
+    if args.stops < 2 or args.min_route < 2 or args.max_route < args.min_route:
+        raise SystemExit("need at least 2 stops and 2 <= --min-route <= --max-route")
+
+    rng = random.Random(args.seed)
+    mix = parse_mix(args.mix)
+
+    # Около 40 остановок на квадратный километр, город квадратный
+    side = math.sqrt(args.stops / 40) * 1000
+    lat_span = side / EARTH_RADIUS * 180 / math.pi
+    lon_span = lat_span / math.cos(math.radians(55.75))
+    coords = [(55.75 + rng.random() * lat_span, 37.6 + rng.random() * lon_span)
+              for _ in range(args.stops)]
+    names = make_names(args.stops, args.names, rng)
+    is_hub = [rng.random() < args.hubs for _ in range(args.stops)]
+    grid = Grid(coords, lat_span / max(1, math.sqrt(args.stops / 8)))
+
+    road_distances = [{} for _ in range(args.stops)]
+
+    def set_distance(a, b):
+        if names[b] not in road_distances[a]:
+            road_distances[a][names[b]] = round(distance(coords[a], coords[b]) * rng.uniform(1.1, 1.5)) + 1
+
+    buses = []
+    for number in range(args.buses):
+        route = make_route(rng.randrange(args.stops), rng.randint(args.min_route, args.max_route),
+                           grid, is_hub, args.transfer_density, rng)
+        if len(route) < 2:
+            continue
+        is_roundtrip = rng.random() < args.roundtrip
+        if is_roundtrip:
+            route.append(route[0])
+        for a, b in zip(route, route[1:]):
+            set_distance(a, b)
+            if rng.random() < args.distance_coverage or not is_roundtrip:
+                set_distance(b, a)
+        bus = {"type": "Bus", "name": f"{number}", "stops": [names[stop] for stop in route],
+               "is_roundtrip": is_roundtrip}
+        if rng.random() < args.schedules:
+            first = rng.randint(300, 420)
+            bus["schedule"] = {"first_departure": first, "last_departure": first + 1000,
+                               "interval": rng.choice((5, 10, 15, 20, 30))}
+        buses.append(bus)
+
+    stops = [{"type": "Stop", "name": names[i], "latitude": coords[i][0], "longitude": coords[i][1],
+              "road_distances": road_distances[i]} for i in range(args.stops)]
+    base_requests = stops + buses
+    rng.shuffle(base_requests)
+
+    def random_stop():
+        return rng.choice(names)
+
+    def make_request(kind):
+        if kind == "Stop" or kind == "Bus" and not buses:
+            return {"type": "Stop", "name": random_stop()}
+        if kind == "Bus":
+            return {"type": "Bus", "name": rng.choice(buses)["name"]}
+        if kind == "Map":
+            return {"type": "Map"}
+        if kind == "Isochrone":
+            return {"type": "Isochrone", "from": random_stop(), "time": rng.choice((10, 20, 30))}
+        if kind == "Matrix":
+            return {"type": "Matrix", "from": [random_stop() for _ in range(8)],
+                    "to": [random_stop() for _ in range(8)], "transfers": True}
+        request = {"type": "Route", "from": random_stop(), "to": random_stop()}
+        if kind == "Pareto":
+            request["pareto"] = True
+        elif kind == "Alternatives":
+            request["max_alternatives"] = 3
+        elif kind == "Timetable":
+            request["departure_time"] = rng.randint(360, 1200)
+        return request
+
+    kinds = list(mix)
+    weights = [mix[kind] for kind in kinds]
+    stat_requests = []
+    for request_id in range(args.requests):
+        request = make_request(rng.choices(kinds, weights)[0])
+        request["id"] = request_id
+        stat_requests.append(request)
+
+    render_settings = {
+        "width": args.width, "height": args.height, "padding": 50,
+        "stop_radius": 3, "line_width": 4,
+        "stop_label_font_size": 12, "stop_label_offset": [7, -3],
+        "bus_label_font_size": 14, "bus_label_offset": [7, 15],
+        "underlayer_color": [255, 255, 255, 0.85], "underlayer_width": 3,
+        "color_palette": ["green", [255, 160, 0], "red", [30, 144, 255], "purple"],
+        "output_format": args.format,
+    }
+    if args.lod_tolerance > 0:
+        render_settings["lod_tolerance"] = args.lod_tolerance
+    routing_settings = {"bus_wait_time": 6, "bus_velocity": 40}
+    if args.route_cache_mb > 0:
+        routing_settings["route_cache_mb"] = args.route_cache_mb
+    document = {
+        "base_requests": base_requests,
+        "render_settings": render_settings,
+        "routing_settings": routing_settings,
+        "stat_requests": stat_requests,
+    }
+    if args.compression != "none" or args.map_files:
+        document["output_settings"] = {"compression": args.compression, "map_files": args.map_files}
+    # Разборщик JSON не понимает \\u-последовательности, поэтому UTF-8 пишется как есть
+    output = sys.stdout if args.output == "-" else open(args.output, "w", encoding="utf-8")
+    with output:
+        json.dump(document, output, ensure_ascii=False)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,285 @@
+#include "binary_protocol.h"
+#include "metrics.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace binary {
+
+void WriteVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void WriteSignedVarint(std::string& out, int64_t value) {
+    WriteVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void WriteDouble(std::string& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int shift = 0; shift < 64; shift += 8) {
+        out.push_back(static_cast<char>((bits >> shift) & 0xFF));
+    }
+}
+
+void WriteString(std::string& out, std::string_view value) {
+    WriteVarint(out, value.size());
+    out.append(value);
+}
+
+uint8_t MessageReader::ReadByte() {
+    if (data_.empty()) {
+        throw std::invalid_argument("Truncated binary message");
+    }
+    const uint8_t byte = static_cast<uint8_t>(data_.front());
+    data_.remove_prefix(1);
+    return byte;
+}
+
+uint64_t MessageReader::ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const uint8_t byte = ReadByte();
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::invalid_argument("Varint is too long");
+}
+
+int64_t MessageReader::ReadSignedVarint() {
+    const uint64_t value = ReadVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+double MessageReader::ReadDouble() {
+    uint64_t bits = 0;
+    for (int shift = 0; shift < 64; shift += 8) {
+        bits |= static_cast<uint64_t>(ReadByte()) << shift;
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view MessageReader::ReadString() {
+    const uint64_t size = ReadVarint();
+    if (size > data_.size()) {
+        throw std::invalid_argument("Truncated binary message");
+    }
+    const std::string_view value = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return value;
+}
+
+std::string_view MessageReader::ReadRest() {
+    const std::string_view rest = data_;
+    data_ = {};
+    return rest;
+}
+
+bool ReadFrame(std::istream& in, std::string& payload) {
+    uint64_t size = 0;
+    for (int shift = 0;; shift += 7) {
+        const auto ch = in.get();
+        if (ch == std::istream::traits_type::eof()) {
+            if (shift == 0) {
+                return false;
+            }
+            throw std::invalid_argument("Truncated binary frame");
+        }
+        if (shift >= 64) {
+            throw std::invalid_argument("Varint is too long");
+        }
+        size |= static_cast<uint64_t>(ch & 0x7F) << shift;
+        if ((ch & 0x80) == 0) {
+            break;
+        }
+    }
+    if (size > MAX_FRAME_SIZE) {
+        throw std::invalid_argument("Binary frame is too large");
+    }
+    payload.resize(size);
+    if (!in.read(payload.data(), static_cast<std::streamsize>(size))) {
+        throw std::invalid_argument("Truncated binary frame");
+    }
+    return true;
+}
+
+void WriteFrame(std::ostream& out, std::string_view payload) {
+    std::string header;
+    WriteVarint(header, payload.size());
+    out.write(header.data(), header.size());
+    out.write(payload.data(), payload.size());
+}
+
+Server::Server(const RequestHandler& handler)
+    : handler_(handler)
+    , stop_names_(handler.GetStopNamesById())
+    , bus_names_(handler.GetSortedBusNames()) {
+    stop_ids_.reserve(stop_names_.size());
+    for (uint32_t id = 0; id < stop_names_.size(); ++id) {
+        stop_ids_.emplace(stop_names_[id], id);
+    }
+    bus_ids_.reserve(bus_names_.size());
+    for (uint32_t id = 0; id < bus_names_.size(); ++id) {
+        bus_ids_.emplace(bus_names_[id], id);
+    }
+}
+
+void Server::Serve(std::istream& in, std::ostream& out, bool flush_each_response) const {
+    std::string request;
+    std::string response;
+    while (ReadFrame(in, request)) {
+        response.clear();
+        HandleMessage(request, response);
+        WriteFrame(out, response);
+        if (flush_each_response) {
+            out.flush();
+        }
+    }
+}
+
+void Server::HandleMessage(std::string_view request, std::string& response) const {
+    TC_METRICS_SCOPE("binary_request");
+    MessageReader reader(request);
+    switch (static_cast<MessageType>(reader.ReadByte())) {
+    case MessageType::HELLO:
+        if (reader.ReadVarint() != PROTOCOL_VERSION) {
+            throw std::invalid_argument("Unsupported binary protocol version");
+        }
+        WriteDictionary(response);
+        return;
+    case MessageType::STOP: {
+        const uint64_t request_id = reader.ReadVarint();
+        WriteStopInfo(request_id, reader.ReadVarint(), response);
+        return;
+    }
+    case MessageType::BUS: {
+        const uint64_t request_id = reader.ReadVarint();
+        WriteBusInfo(request_id, reader.ReadVarint(), response);
+        return;
+    }
+    case MessageType::ROUTE: {
+        const uint64_t request_id = reader.ReadVarint();
+        const uint64_t from = reader.ReadVarint();
+        WriteRouteInfo(request_id, from, reader.ReadVarint(), response);
+        return;
+    }
+    case MessageType::MAP:
+        WriteMapData(reader.ReadVarint(), response);
+        return;
+#ifdef TC_METRICS
+    case MessageType::METRICS:
+        WriteMetricsData(reader.ReadVarint(), response);
+        return;
+#endif
+    default:
+        throw std::invalid_argument("Unknown binary message type");
+    }
+}
+
+void Server::WriteDictionary(std::string& response) const {
+    response.push_back(static_cast<char>(MessageType::DICTIONARY));
+    WriteVarint(response, PROTOCOL_VERSION);
+    WriteVarint(response, stop_names_.size());
+    for (const std::string_view name : stop_names_) {
+        WriteString(response, name);
+    }
+    WriteVarint(response, bus_names_.size());
+    for (const std::string_view name : bus_names_) {
+        WriteString(response, name);
+    }
+}
+
+namespace {
+void WriteNotFound(uint64_t request_id, std::string& response) {
+    response.push_back(static_cast<char>(MessageType::NOT_FOUND));
+    WriteVarint(response, request_id);
+}
+}
+
+void Server::WriteStopInfo(uint64_t request_id, uint64_t stop, std::string& response) const {
+    if (stop >= stop_names_.size()) {
+        WriteNotFound(request_id, response);
+        return;
+    }
+    const auto buses = handler_.GetBusesByStop(stop_names_[stop]);
+    response.push_back(static_cast<char>(MessageType::STOP_INFO));
+    WriteVarint(response, request_id);
+    WriteVarint(response, buses.size());
+    for (const std::string_view bus_name : buses) {
+        WriteVarint(response, bus_ids_.at(bus_name));
+    }
+}
+
+void Server::WriteBusInfo(uint64_t request_id, uint64_t bus, std::string& response) const {
+    const auto bus_stat = bus < bus_names_.size() ? handler_.GetBusStat(bus_names_[bus]) : std::nullopt;
+    if (!bus_stat) {
+        WriteNotFound(request_id, response);
+        return;
+    }
+    response.push_back(static_cast<char>(MessageType::BUS_INFO));
+    WriteVarint(response, request_id);
+    WriteDouble(response, bus_stat->curvature);
+    WriteVarint(response, bus_stat->route_length);
+    WriteVarint(response, bus_stat->stops_on_route);
+    WriteVarint(response, bus_stat->unique_stops);
+}
+
+void Server::WriteRouteInfo(uint64_t request_id, uint64_t from, uint64_t to, std::string& response) const {
+    const auto route = from < stop_names_.size() && to < stop_names_.size()
+                     ? handler_.GetRoute(std::string(stop_names_[from]), std::string(stop_names_[to]))
+                     : std::nullopt;
+    if (!route) {
+        WriteNotFound(request_id, response);
+        return;
+    }
+    double total_time = 0;
+    for (const auto& edge : *route) {
+        total_time += edge.time;
+    }
+    response.push_back(static_cast<char>(MessageType::ROUTE_INFO));
+    WriteVarint(response, request_id);
+    WriteDouble(response, total_time);
+    WriteVarint(response, route->size());
+    for (const auto& edge : *route) {
+        WriteVarint(response, stop_ids_.at(edge.start_stop));
+        WriteDouble(response, edge.wait_time);
+        WriteVarint(response, bus_ids_.at(edge.bus));
+        WriteSignedVarint(response, edge.stop_count);
+        WriteDouble(response, edge.time - edge.wait_time);
+    }
+}
+
+void Server::WriteMapData(uint64_t request_id, std::string& response) const {
+    const bool png = handler_.GetMapFormat() == render::MapFormat::PNG;
+    std::ostringstream map_out;
+    if (png) {
+        handler_.RenderMapPng(map_out);
+    } else {
+        handler_.RenderMap(map_out);
+    }
+    response.push_back(static_cast<char>(MessageType::MAP_DATA));
+    WriteVarint(response, request_id);
+    WriteVarint(response, png ? 1 : 0);
+    response += map_out.str();
+}
+
+#ifdef TC_METRICS
+void Server::WriteMetricsData(uint64_t request_id, std::string& response) const {
+    std::ostringstream metrics_out;
+    metrics::Registry::Instance().PrintJson(metrics_out);
+    response.push_back(static_cast<char>(MessageType::METRICS_DATA));
+    WriteVarint(response, request_id);
+    response += metrics_out.str();
+}
+#endif
+
+}  // namespace binary
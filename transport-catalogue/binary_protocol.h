@@ -0,0 +1,122 @@
+#pragma once
+
+#include "request_handler.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Компактный двоичный протокол запросов Stop, Bus, Route и Map для клиентов с большим
+// числом мелких запросов. Поток состоит из кадров: длина содержимого в формате varint,
+// затем само содержимое, первый байт которого - тип сообщения.
+//
+// varint - целое без знака, по 7 бит в байте начиная с младших, старший бит байта
+// означает продолжение (LEB128). svarint - целое со знаком, записанное как varint
+// в зигзаг-кодировании: 0, -1, 1, -2 ... переходят в 0, 1, 2, 3 ...
+// double - 8 байт IEEE 754 в порядке little-endian. Строка - длина varint и байты UTF-8.
+// Номера запросов неотрицательные.
+//
+// Вместо имён остановок и маршрутов передаются их номера. Номер остановки - её номер
+// в справочнике, номер маршрута - позиция в списке имён маршрутов по возрастанию.
+// Таблицы имён клиент получает в ответ на HELLO и может запросить их повторно.
+//
+// Запросы клиента:
+//   HELLO      0x01  version
+//   STOP       0x02  request_id, stop
+//   BUS        0x03  request_id, bus
+//   ROUTE      0x04  request_id, from_stop, to_stop
+//   MAP        0x05  request_id
+//   METRICS    0x06  request_id, только в сборке с TC_METRICS, иначе сообщение неизвестно
+// Ответы сервера, по одному кадру на запрос в порядке запросов:
+//   DICTIONARY 0x81  version, stop_count, имена остановок, bus_count, имена маршрутов
+//   STOP_INFO  0x82  request_id, bus_count, номера маршрутов по возрастанию имён
+//   BUS_INFO   0x83  request_id, curvature (double), route_length, stop_count, unique_stop_count
+//   ROUTE_INFO 0x84  request_id, total_time (double), ride_count, поездки:
+//                    stop, wait_time (double), bus, span_count (svarint), time (double)
+//   MAP_DATA   0x85  request_id, format (0 - SVG, 1 - PNG), данные карты до конца кадра
+//   METRICS_DATA 0x86  request_id, отчёт о замерах в JSON, как в metrics.json, до конца кадра
+//   NOT_FOUND  0x8F  request_id
+// Поля без пометки - varint. Все поля, кроме данных карты и отчёта, передаются целиком
+namespace binary {
+
+constexpr uint64_t PROTOCOL_VERSION = 1;
+// Кадры длиннее считаются повреждёнными
+constexpr uint64_t MAX_FRAME_SIZE = 256 * 1024 * 1024;
+
+enum class MessageType : uint8_t {
+    HELLO = 0x01,
+    STOP = 0x02,
+    BUS = 0x03,
+    ROUTE = 0x04,
+    MAP = 0x05,
+    METRICS = 0x06,
+    DICTIONARY = 0x81,
+    STOP_INFO = 0x82,
+    BUS_INFO = 0x83,
+    ROUTE_INFO = 0x84,
+    MAP_DATA = 0x85,
+    METRICS_DATA = 0x86,
+    NOT_FOUND = 0x8F,
+};
+
+void WriteVarint(std::string& out, uint64_t value);
+void WriteSignedVarint(std::string& out, int64_t value);
+void WriteDouble(std::string& out, double value);
+void WriteString(std::string& out, std::string_view value);
+
+// Чтение полей сообщения. При нехватке данных бросает std::invalid_argument
+class MessageReader {
+public:
+    explicit MessageReader(std::string_view data) : data_(data) {}
+
+    uint8_t ReadByte();
+    uint64_t ReadVarint();
+    int64_t ReadSignedVarint();
+    double ReadDouble();
+    std::string_view ReadString();
+    // Непрочитанный остаток сообщения
+    std::string_view ReadRest();
+
+private:
+    std::string_view data_;
+};
+
+// Читает следующий кадр в payload. Возвращает false, если поток закончился до начала кадра.
+// Оборванный или слишком длинный кадр - std::invalid_argument
+bool ReadFrame(std::istream& in, std::string& payload);
+void WriteFrame(std::ostream& out, std::string_view payload);
+
+// Отвечает на запросы двоичного протокола через тот же RequestHandler, что и JSON
+class Server {
+public:
+    explicit Server(const RequestHandler& handler);
+
+    // Отвечает на кадры из in, пока они не закончатся. В режиме сервера flush_each_response
+    // сбрасывает out после каждого ответа, чтобы клиент получил его сразу
+    void Serve(std::istream& in, std::ostream& out, bool flush_each_response) const;
+    // Дописывает в response содержимое кадра ответа на сообщение request.
+    // Неизвестный тип сообщения - std::invalid_argument
+    void HandleMessage(std::string_view request, std::string& response) const;
+
+private:
+    void WriteDictionary(std::string& response) const;
+    void WriteStopInfo(uint64_t request_id, uint64_t stop, std::string& response) const;
+    void WriteBusInfo(uint64_t request_id, uint64_t bus, std::string& response) const;
+    void WriteRouteInfo(uint64_t request_id, uint64_t from, uint64_t to, std::string& response) const;
+    void WriteMapData(uint64_t request_id, std::string& response) const;
+#ifdef TC_METRICS
+    void WriteMetricsData(uint64_t request_id, std::string& response) const;
+#endif
+
+    const RequestHandler& handler_;
+    std::vector<std::string_view> stop_names_;
+    std::vector<std::string_view> bus_names_;
+    std::unordered_map<std::string_view, uint32_t> stop_ids_;
+    std::unordered_map<std::string_view, uint32_t> bus_ids_;
+};
+
+}  // namespace binary
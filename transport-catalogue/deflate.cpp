@@ -0,0 +1,589 @@
+#include "deflate.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+namespace deflate {
+
+namespace {
+
+constexpr size_t WINDOW_SIZE = 32768;
+constexpr size_t WINDOW_MASK = WINDOW_SIZE - 1;
+constexpr size_t MIN_MATCH = 3;
+constexpr size_t MAX_MATCH = 258;
+constexpr int HASH_BITS = 15;
+// Сколько кандидатов проверяется в хеш-цепочке и какой длины повтора достаточно, чтобы остановиться
+constexpr int MAX_CHAIN = 64;
+constexpr size_t NICE_MATCH = 128;
+// Сколько входных байт попадает в один блок
+constexpr size_t BLOCK_SIZE = 1 << 17;
+constexpr size_t OUT_BUFFER_SIZE = 1 << 16;
+// Наибольшая длина блока без сжатия
+constexpr size_t MAX_STORED_SIZE = 65535;
+
+constexpr int MAX_CODE_BITS = 15;
+constexpr int MAX_CODE_LENGTH_BITS = 7;
+constexpr size_t LITERAL_CODES = 286;
+constexpr size_t DIST_CODES = 30;
+constexpr size_t CODE_LENGTH_CODES = 19;
+constexpr uint16_t END_OF_BLOCK = 256;
+
+constexpr std::array<uint16_t, 29> LENGTH_BASE = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> LENGTH_EXTRA = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> DIST_BASE = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> DIST_EXTRA = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Порядок, в котором записываются длины кодов алфавита длин
+constexpr std::array<uint8_t, CODE_LENGTH_CODES> CODE_LENGTH_ORDER = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+size_t GetLengthCode(size_t length) {
+    return std::upper_bound(LENGTH_BASE.begin(), LENGTH_BASE.end(), length) - LENGTH_BASE.begin() - 1;
+}
+
+size_t GetDistCode(size_t dist) {
+    return std::upper_bound(DIST_BASE.begin(), DIST_BASE.end(), dist) - DIST_BASE.begin() - 1;
+}
+
+// Длины кодов Хаффмана для частот freqs, не длиннее max_bits.
+// Символов с ненулевой частотой должно быть хотя бы два, иначе распаковщик
+// не примет неполный код, поэтому недостающие добавляются с частотой 1
+std::vector<uint8_t> BuildLengths(std::vector<uint32_t> freqs, int max_bits) {
+    for (size_t symbol = 0, used = std::count_if(freqs.begin(), freqs.end(), [](uint32_t freq) {
+             return freq != 0;
+         }); used < 2; ++symbol) {
+        if (freqs[symbol] == 0) {
+            freqs[symbol] = 1;
+            ++used;
+        }
+    }
+    std::vector<size_t> symbols;
+    for (size_t symbol = 0; symbol < freqs.size(); ++symbol) {
+        if (freqs[symbol] != 0) {
+            symbols.push_back(symbol);
+        }
+    }
+    std::stable_sort(symbols.begin(), symbols.end(), [&freqs](size_t left, size_t right) {
+        return freqs[left] < freqs[right];
+    });
+
+    // Дерево строится двумя очередями: листья уже упорядочены, а внутренние узлы
+    // появляются в порядке неубывания веса. Узлы [0, count) - листья
+    const size_t count = symbols.size();
+    std::vector<uint64_t> weights(2 * count - 1);
+    std::vector<size_t> parents(2 * count - 1);
+    for (size_t i = 0; i < count; ++i) {
+        weights[i] = freqs[symbols[i]];
+    }
+    size_t leaf = 0;
+    size_t node = count;
+    for (size_t next = count; next < weights.size(); ++next) {
+        auto take = [&]() {
+            if (leaf < count && (node == next || weights[leaf] <= weights[node])) {
+                return leaf++;
+            }
+            return node++;
+        };
+        const size_t first = take();
+        const size_t second = take();
+        weights[next] = weights[first] + weights[second];
+        parents[first] = parents[second] = next;
+    }
+    std::vector<int> depths(weights.size());
+    std::array<uint32_t, MAX_CODE_BITS + 1> length_counts{};
+    for (size_t i = weights.size() - 1; i-- > 0;) {
+        depths[i] = depths[parents[i]] + 1;
+        if (i < count) {
+            ++length_counts[std::min(depths[i], max_bits)];
+        }
+    }
+
+    // Длинные коды укорачиваются до max_bits, после чего сумма Крафта превышает единицу.
+    // Она уменьшается переносом листьев на уровень ниже, пока код снова не станет полным
+    uint32_t kraft_sum = 0;
+    for (int length = 1; length <= max_bits; ++length) {
+        kraft_sum += length_counts[length] << (max_bits - length);
+    }
+    while (kraft_sum > (1u << max_bits)) {
+        --length_counts[max_bits];
+        for (int length = max_bits - 1; length > 0; --length) {
+            if (length_counts[length] != 0) {
+                --length_counts[length];
+                length_counts[length + 1] += 2;
+                break;
+            }
+        }
+        --kraft_sum;
+    }
+
+    // Самые редкие символы получают самые длинные коды
+    std::vector<uint8_t> lengths(freqs.size());
+    size_t index = 0;
+    for (int length = max_bits; length > 0; --length) {
+        for (uint32_t i = 0; i < length_counts[length]; ++i) {
+            lengths[symbols[index++]] = static_cast<uint8_t>(length);
+        }
+    }
+    return lengths;
+}
+
+// Канонические коды по длинам. Биты кода развёрнуты, потому что deflate
+// пишет коды Хаффмана начиная со старшего бита, а остальные поля - с младшего
+std::vector<uint16_t> BuildCodes(const std::vector<uint8_t>& lengths) {
+    std::array<uint16_t, MAX_CODE_BITS + 2> next_code{};
+    std::array<uint16_t, MAX_CODE_BITS + 1> length_counts{};
+    for (const uint8_t length : lengths) {
+        ++length_counts[length];
+    }
+    length_counts[0] = 0;
+    for (int length = 1; length <= MAX_CODE_BITS; ++length) {
+        next_code[length + 1] = static_cast<uint16_t>((next_code[length] + length_counts[length]) << 1);
+    }
+    std::vector<uint16_t> codes(lengths.size());
+    for (size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+        const int length = lengths[symbol];
+        if (length == 0) {
+            continue;
+        }
+        uint16_t code = next_code[length]++;
+        uint16_t reversed = 0;
+        for (int bit = 0; bit < length; ++bit) {
+            reversed = static_cast<uint16_t>((reversed << 1) | (code & 1));
+            code >>= 1;
+        }
+        codes[symbol] = reversed;
+    }
+    return codes;
+}
+
+uint32_t GetHash(const char* data) {
+    const uint32_t value = static_cast<uint8_t>(data[0]) | static_cast<uint8_t>(data[1]) << 8
+                           | static_cast<uint8_t>(data[2]) << 16;
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+}  // namespace
+
+uint32_t Crc32(std::string_view data, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            result[i] = value;
+        }
+        return result;
+    }();
+    crc = ~crc;
+    for (const char c : data) {
+        crc = table[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t Adler32(std::string_view data, uint32_t adler) {
+    // Суммы накапливаются кусками, после которых ещё не может случиться переполнение
+    constexpr size_t MAX_RUN = 5552;
+    constexpr uint32_t MOD = 65521;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (!data.empty()) {
+        const size_t run = std::min(data.size(), MAX_RUN);
+        for (size_t i = 0; i < run; ++i) {
+            a += static_cast<uint8_t>(data[i]);
+            b += a;
+        }
+        a %= MOD;
+        b %= MOD;
+        data.remove_prefix(run);
+    }
+    return b << 16 | a;
+}
+
+Compressor::Compressor(std::ostream& out)
+    : out_(out)
+    , head_(size_t{1} << HASH_BITS)
+    , prev_(WINDOW_SIZE) {
+}
+
+void Compressor::Write(std::string_view data) {
+    buffer_.append(data);
+    // Блок сжимается, когда после него есть ещё MAX_MATCH байт и повтор у конца блока не обрывается
+    while (buffer_.size() - history_size_ >= BLOCK_SIZE + MAX_MATCH) {
+        CompressBlock(false);
+    }
+}
+
+void Compressor::Finish() {
+    if (finished_) {
+        return;
+    }
+    CompressBlock(true);
+    if (bit_count_ > 0) {
+        WriteBits(0, (8 - bit_count_ % 8) % 8);
+    }
+    FlushBytes();
+    out_.write(out_buffer_.data(), out_buffer_.size());
+    out_buffer_.clear();
+    finished_ = true;
+}
+
+void Compressor::CompressBlock(bool final) {
+    const size_t end = final ? buffer_.size() : history_size_ + BLOCK_SIZE;
+    tokens_.clear();
+    FindTokens(history_size_, end);
+
+    // Последний повтор мог выйти за конец блока, поэтому сжатая часть считается по токенам
+    size_t compressed_end = history_size_;
+    for (const Token& token : tokens_) {
+        compressed_end += token.dist == 0 ? 1 : token.length;
+    }
+    WriteBlock(history_size_, compressed_end, final);
+    const size_t drop = compressed_end > WINDOW_SIZE ? compressed_end - WINDOW_SIZE : 0;
+    buffer_.erase(0, drop);
+    buffer_offset_ += drop;
+    history_size_ = compressed_end - drop;
+}
+
+void Compressor::InsertHash(size_t pos) {
+    if (pos + MIN_MATCH > buffer_.size()) {
+        return;
+    }
+    const uint64_t absolute_pos = buffer_offset_ + pos;
+    uint64_t& head = head_[GetHash(buffer_.data() + pos)];
+    // Нулём обозначается пустая цепочка, поэтому позиции хранятся со сдвигом на единицу
+    prev_[absolute_pos & WINDOW_MASK] = head;
+    head = absolute_pos + 1;
+}
+
+size_t Compressor::FindMatch(size_t pos, size_t end, size_t& match_pos) const {
+    if (pos + MIN_MATCH > buffer_.size() || pos >= end) {
+        return 0;
+    }
+    const size_t max_length = std::min(MAX_MATCH, buffer_.size() - pos);
+    const uint64_t absolute_pos = buffer_offset_ + pos;
+    const char* data = buffer_.data();
+    size_t best_length = 0;
+    uint64_t candidate = head_[GetHash(data + pos)];
+    uint64_t last_candidate = absolute_pos + 1;
+    for (int chain = 0; chain < MAX_CHAIN && candidate != 0; ++chain) {
+        // Ячейки prev_ переиспользуются по кругу, поэтому цепочка обрывается,
+        // как только кандидат выходит из окна или перестаёт убывать
+        if (candidate >= last_candidate || absolute_pos - (candidate - 1) > WINDOW_SIZE
+            || candidate - 1 < buffer_offset_) {
+            break;
+        }
+        last_candidate = candidate;
+        const size_t candidate_pos = candidate - 1 - buffer_offset_;
+        if (data[candidate_pos + best_length] == data[pos + best_length]) {
+            size_t length = 0;
+            while (length < max_length && data[candidate_pos + length] == data[pos + length]) {
+                ++length;
+            }
+            if (length > best_length) {
+                best_length = length;
+                match_pos = candidate_pos;
+                if (length >= NICE_MATCH || length == max_length) {
+                    break;
+                }
+            }
+        }
+        candidate = prev_[(candidate - 1) & WINDOW_MASK];
+    }
+    return best_length >= MIN_MATCH ? best_length : 0;
+}
+
+void Compressor::FindTokens(size_t begin, size_t end) {
+    size_t pos = begin;
+    while (pos < end) {
+        size_t match_pos = 0;
+        const size_t length = FindMatch(pos, end, match_pos);
+        InsertHash(pos);
+        if (length != 0 && length < NICE_MATCH) {
+            // Ленивый поиск: если со следующего байта повтор длиннее, текущий байт уходит литералом
+            size_t next_match_pos = 0;
+            if (FindMatch(pos + 1, end, next_match_pos) > length) {
+                tokens_.push_back({static_cast<uint8_t>(buffer_[pos]), 0});
+                ++pos;
+                continue;
+            }
+        }
+        if (length == 0) {
+            tokens_.push_back({static_cast<uint8_t>(buffer_[pos]), 0});
+            ++pos;
+            continue;
+        }
+        tokens_.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(pos - match_pos)});
+        for (size_t i = pos + 1; i < pos + length; ++i) {
+            InsertHash(i);
+        }
+        pos += length;
+    }
+}
+
+void Compressor::WriteBlock(size_t begin, size_t end, bool final) {
+    if (tokens_.empty()) {
+        // Пустой блок с фиксированными кодами: только конец блока, код которого - семь нулей
+        WriteBits(final ? 1 : 0, 1);
+        WriteBits(1, 2);
+        WriteBits(0, 7);
+        return;
+    }
+
+    std::vector<uint32_t> literal_freqs(LITERAL_CODES);
+    std::vector<uint32_t> dist_freqs(DIST_CODES);
+    for (const Token& token : tokens_) {
+        if (token.dist == 0) {
+            ++literal_freqs[token.length];
+        } else {
+            ++literal_freqs[257 + GetLengthCode(token.length)];
+            ++dist_freqs[GetDistCode(token.dist)];
+        }
+    }
+    literal_freqs[END_OF_BLOCK] = 1;
+    const std::vector<uint8_t> literal_lengths = BuildLengths(literal_freqs, MAX_CODE_BITS);
+    const std::vector<uint8_t> dist_lengths = BuildLengths(dist_freqs, MAX_CODE_BITS);
+    const std::vector<uint16_t> literal_codes = BuildCodes(literal_lengths);
+    const std::vector<uint16_t> dist_codes = BuildCodes(dist_lengths);
+
+    size_t literal_count = LITERAL_CODES;
+    while (literal_count > 257 && literal_lengths[literal_count - 1] == 0) {
+        --literal_count;
+    }
+    size_t dist_count = DIST_CODES;
+    while (dist_count > 1 && dist_lengths[dist_count - 1] == 0) {
+        --dist_count;
+    }
+
+    // Длины обоих кодов записываются одной последовательностью, сжатой повторами:
+    // 16 - повтор предыдущей длины 3-6 раз, 17 и 18 - серии нулей длиной 3-10 и 11-138
+    std::vector<uint8_t> all_lengths(literal_lengths.begin(), literal_lengths.begin() + literal_count);
+    all_lengths.insert(all_lengths.end(), dist_lengths.begin(), dist_lengths.begin() + dist_count);
+    struct LengthSymbol {
+        uint8_t symbol;
+        uint8_t extra;
+    };
+    std::vector<LengthSymbol> length_symbols;
+    for (size_t i = 0; i < all_lengths.size();) {
+        const uint8_t length = all_lengths[i];
+        size_t run = 1;
+        while (i + run < all_lengths.size() && all_lengths[i + run] == length) {
+            ++run;
+        }
+        i += run;
+        if (length == 0) {
+            while (run >= 11) {
+                const size_t part = std::min<size_t>(run, 138);
+                length_symbols.push_back({18, static_cast<uint8_t>(part - 11)});
+                run -= part;
+            }
+            if (run >= 3) {
+                length_symbols.push_back({17, static_cast<uint8_t>(run - 3)});
+                run = 0;
+            }
+        } else {
+            length_symbols.push_back({length, 0});
+            --run;
+            while (run >= 3) {
+                const size_t part = std::min<size_t>(run, 6);
+                length_symbols.push_back({16, static_cast<uint8_t>(part - 3)});
+                run -= part;
+            }
+        }
+        for (; run > 0; --run) {
+            length_symbols.push_back({length, 0});
+        }
+    }
+    std::vector<uint32_t> code_length_freqs(CODE_LENGTH_CODES);
+    for (const LengthSymbol& length_symbol : length_symbols) {
+        ++code_length_freqs[length_symbol.symbol];
+    }
+    const std::vector<uint8_t> code_length_lengths = BuildLengths(code_length_freqs, MAX_CODE_LENGTH_BITS);
+    const std::vector<uint16_t> code_length_codes = BuildCodes(code_length_lengths);
+    size_t code_length_count = CODE_LENGTH_CODES;
+    while (code_length_count > 4 && code_length_lengths[CODE_LENGTH_ORDER[code_length_count - 1]] == 0) {
+        --code_length_count;
+    }
+
+    // Несжимаемые данные (уже сжатые, случайные) выгоднее записать без кодирования
+    uint64_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * code_length_count;
+    for (const LengthSymbol& length_symbol : length_symbols) {
+        dynamic_bits += code_length_lengths[length_symbol.symbol];
+        if (length_symbol.symbol == 16) {
+            dynamic_bits += 2;
+        } else if (length_symbol.symbol == 17) {
+            dynamic_bits += 3;
+        } else if (length_symbol.symbol == 18) {
+            dynamic_bits += 7;
+        }
+    }
+    for (size_t symbol = 0; symbol < LITERAL_CODES; ++symbol) {
+        dynamic_bits += static_cast<uint64_t>(literal_freqs[symbol]) * literal_lengths[symbol];
+        if (symbol > END_OF_BLOCK && symbol - 257 < LENGTH_EXTRA.size()) {
+            dynamic_bits += static_cast<uint64_t>(literal_freqs[symbol]) * LENGTH_EXTRA[symbol - 257];
+        }
+    }
+    for (size_t symbol = 0; symbol < DIST_CODES; ++symbol) {
+        dynamic_bits += static_cast<uint64_t>(dist_freqs[symbol]) * (dist_lengths[symbol] + DIST_EXTRA[symbol]);
+    }
+    if (GetStoredBits(end - begin) < dynamic_bits) {
+        WriteStoredBlocks(begin, end, final);
+        return;
+    }
+
+    WriteBits(final ? 1 : 0, 1);
+    WriteBits(2, 2);
+    WriteBits(static_cast<uint32_t>(literal_count - 257), 5);
+    WriteBits(static_cast<uint32_t>(dist_count - 1), 5);
+    WriteBits(static_cast<uint32_t>(code_length_count - 4), 4);
+    for (size_t i = 0; i < code_length_count; ++i) {
+        WriteBits(code_length_lengths[CODE_LENGTH_ORDER[i]], 3);
+    }
+    for (const LengthSymbol& length_symbol : length_symbols) {
+        WriteBits(code_length_codes[length_symbol.symbol], code_length_lengths[length_symbol.symbol]);
+        if (length_symbol.symbol == 16) {
+            WriteBits(length_symbol.extra, 2);
+        } else if (length_symbol.symbol == 17) {
+            WriteBits(length_symbol.extra, 3);
+        } else if (length_symbol.symbol == 18) {
+            WriteBits(length_symbol.extra, 7);
+        }
+    }
+
+    for (const Token& token : tokens_) {
+        if (token.dist == 0) {
+            WriteBits(literal_codes[token.length], literal_lengths[token.length]);
+            continue;
+        }
+        const size_t length_code = GetLengthCode(token.length);
+        WriteBits(literal_codes[257 + length_code], literal_lengths[257 + length_code]);
+        WriteBits(token.length - LENGTH_BASE[length_code], LENGTH_EXTRA[length_code]);
+        const size_t dist_code = GetDistCode(token.dist);
+        WriteBits(dist_codes[dist_code], dist_lengths[dist_code]);
+        WriteBits(token.dist - DIST_BASE[dist_code], DIST_EXTRA[dist_code]);
+    }
+    WriteBits(literal_codes[END_OF_BLOCK], literal_lengths[END_OF_BLOCK]);
+}
+
+uint64_t Compressor::GetStoredBits(size_t size) const {
+    // Каждый блок: 3 бита заголовка, выравнивание до байта (не больше 7 бит), LEN и NLEN
+    const uint64_t block_count = std::max<size_t>(1, (size + MAX_STORED_SIZE - 1) / MAX_STORED_SIZE);
+    return block_count * (3 + 7 + 32) + static_cast<uint64_t>(size) * 8;
+}
+
+void Compressor::WriteStoredBlocks(size_t begin, size_t end, bool final) {
+    do {
+        const size_t size = std::min(end - begin, MAX_STORED_SIZE);
+        WriteBits(final && begin + size == end ? 1 : 0, 1);
+        WriteBits(0, 2);
+        WriteBits(0, (8 - bit_count_ % 8) % 8);
+        WriteBits(static_cast<uint32_t>(size), 16);
+        WriteBits(static_cast<uint32_t>(~size & 0xFFFF), 16);
+        FlushBytes();
+        out_buffer_.append(buffer_, begin, size);
+        FlushBytes();
+        begin += size;
+    } while (begin < end);
+}
+
+void Compressor::WriteBits(uint32_t bits, int count) {
+    bit_buffer_ |= static_cast<uint64_t>(bits) << bit_count_;
+    bit_count_ += count;
+    if (bit_count_ >= 32) {
+        FlushBytes();
+    }
+}
+
+void Compressor::FlushBytes() {
+    while (bit_count_ >= 8) {
+        out_buffer_.push_back(static_cast<char>(bit_buffer_ & 0xFF));
+        bit_buffer_ >>= 8;
+        bit_count_ -= 8;
+    }
+    if (out_buffer_.size() >= OUT_BUFFER_SIZE) {
+        out_.write(out_buffer_.data(), out_buffer_.size());
+        out_buffer_.clear();
+    }
+}
+
+std::string Compress(std::string_view data) {
+    std::ostringstream out;
+    Compressor compressor(out);
+    compressor.Write(data);
+    compressor.Finish();
+    return out.str();
+}
+
+std::string CompressZlib(std::string_view data) {
+    // 0x78 0x9C: окно 32 КБ, уровень сжатия по умолчанию, заголовок кратен 31
+    std::string result = "\x78\x9C";
+    result += Compress(data);
+    const uint32_t adler = Adler32(data);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        result.push_back(static_cast<char>((adler >> shift) & 0xFF));
+    }
+    return result;
+}
+
+GzipWriter::Buffer::Buffer(std::ostream& out)
+    : out_(out)
+    , compressor_(out) {
+    // Без имени файла и времени изменения, метод сжатия deflate, ОС не указана
+    static constexpr char HEADER[] = {'\x1F', '\x8B', 8, 0, 0, 0, 0, 0, 0, '\xFF'};
+    out_.write(HEADER, sizeof(HEADER));
+    setp(data_, data_ + sizeof(data_));
+}
+
+GzipWriter::Buffer::int_type GzipWriter::Buffer::overflow(int_type ch) {
+    Flush();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int GzipWriter::Buffer::sync() {
+    Flush();
+    return out_ ? 0 : -1;
+}
+
+void GzipWriter::Buffer::Flush() {
+    const std::string_view data(pbase(), pptr() - pbase());
+    crc_ = Crc32(data, crc_);
+    size_ += static_cast<uint32_t>(data.size());
+    compressor_.Write(data);
+    setp(data_, data_ + sizeof(data_));
+}
+
+void GzipWriter::Buffer::Finish() {
+    Flush();
+    compressor_.Finish();
+    for (const uint32_t value : {crc_, size_}) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            out_.put(static_cast<char>((value >> shift) & 0xFF));
+        }
+    }
+}
+
+GzipWriter::GzipWriter(std::ostream& out)
+    : std::ostream(nullptr)
+    , buffer_(out) {
+    rdbuf(&buffer_);
+}
+
+GzipWriter::~GzipWriter() {
+    buffer_.Finish();
+}
+
+}  // namespace deflate
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace deflate {
+
+uint32_t Crc32(std::string_view data, uint32_t crc = 0);
+uint32_t Adler32(std::string_view data, uint32_t adler = 1);
+
+// Потоковое сжатие в формате deflate (RFC 1951): поиск повторов в окне 32 КБ
+// по хеш-цепочкам и блоки с динамическими кодами Хаффмана. Блок, который при сжатии
+// не становится короче, записывается без сжатия.
+// Данные копятся во внутреннем буфере и сжимаются блоками, сжатый поток пишется в out
+class Compressor {
+public:
+    explicit Compressor(std::ostream& out);
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    void Write(std::string_view data);
+    // Сжимает остаток данных и завершает поток последним блоком. После Finish писать нельзя
+    void Finish();
+
+private:
+    // Литерал, если dist == 0, иначе повтор длины length на расстоянии dist
+    struct Token {
+        uint16_t length;
+        uint16_t dist;
+    };
+
+    void CompressBlock(bool final);
+    void FindTokens(size_t begin, size_t end);
+    // Длина и положение самого длинного повтора для позиции pos в буфере
+    size_t FindMatch(size_t pos, size_t end, size_t& match_pos) const;
+    void InsertHash(size_t pos);
+    // Записывает блок с данными buffer_[begin, end), закодированными токенами tokens_
+    void WriteBlock(size_t begin, size_t end, bool final);
+    // Размер в битах данных длины size, записанных блоками без сжатия
+    uint64_t GetStoredBits(size_t size) const;
+    void WriteStoredBlocks(size_t begin, size_t end, bool final);
+    void WriteBits(uint32_t bits, int count);
+    void FlushBytes();
+
+    std::ostream& out_;
+    // Последние WINDOW_SIZE байт уже сжатых данных и за ними ещё не сжатые
+    std::string buffer_;
+    size_t history_size_ = 0;
+    // Сколько байт отброшено из начала buffer_: позиции в хеш-цепочках абсолютные
+    uint64_t buffer_offset_ = 0;
+    std::vector<uint64_t> head_;
+    std::vector<uint64_t> prev_;
+    std::vector<Token> tokens_;
+
+    uint64_t bit_buffer_ = 0;
+    int bit_count_ = 0;
+    std::string out_buffer_;
+    bool finished_ = false;
+};
+
+// Поток gzip (RFC 1952) поверх out: записанное сжимается по мере заполнения буфера,
+// заголовок пишется сразу, а контрольная сумма CRC-32 и длина - в деструкторе
+class GzipWriter : public std::ostream {
+public:
+    explicit GzipWriter(std::ostream& out);
+    ~GzipWriter() override;
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        explicit Buffer(std::ostream& out);
+        void Finish();
+
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+
+    private:
+        void Flush();
+
+        std::ostream& out_;
+        Compressor compressor_;
+        uint32_t crc_ = 0;
+        // Длина несжатых данных по модулю 2^32, как её хранит gzip
+        uint32_t size_ = 0;
+        char data_[65536];
+    };
+
+    Buffer buffer_;
+};
+
+// Сжатые данные в формате deflate
+std::string Compress(std::string_view data);
+// Поток zlib (RFC 1950): заголовок, данные deflate и контрольная сумма Adler-32
+std::string CompressZlib(std::string_view data);
+
+}  // namespace deflate
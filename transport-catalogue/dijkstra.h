@@ -0,0 +1,180 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайших путей из одной вершины алгоритмом Дейкстры.
+// Рабочие массивы переиспользуются между запусками: перед новым запуском
+// сбрасываются только вершины, достигнутые в предыдущем
+template <typename Weight>
+class ShortestPathSearch {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    explicit ShortestPathSearch(const Graph& graph);
+
+    // Запускает поиск из from. Если задан limit, вершины дальше limit не раскрываются,
+    // и поиск останавливается, как только ближайшая нерассмотренная вершина выходит за предел
+    void Run(VertexId from, const std::optional<Weight>& limit = std::nullopt);
+    // Поиск из from до to, останавливается, как только найден путь до to.
+    // Рёбра, для которых skip_edge(edge_id) вернул true, не рассматриваются
+    template <typename EdgeFilter>
+    void Run(VertexId from, VertexId to, EdgeFilter skip_edge);
+
+    // Вес и предыдущее ребро имеют смысл только для вершин, для которых IsReached вернул true
+    bool IsReached(VertexId vertex) const;
+    const Weight& GetWeight(VertexId vertex) const;
+    std::optional<EdgeId> GetPrevEdge(VertexId vertex) const;
+    // Вершины, до которых найден кратчайший путь, в порядке возрастания веса
+    const std::vector<VertexId>& GetSettledVertices() const;
+    // Рёбра кратчайшего пути из вершины последнего запуска в to
+    std::vector<EdgeId> GetRouteEdges(VertexId to) const;
+
+private:
+    struct QueueItem {
+        Weight weight;
+        VertexId vertex;
+    };
+    struct QueueCompare {
+        bool operator()(const QueueItem& lhs, const QueueItem& rhs) const {
+            return rhs.weight < lhs.weight;
+        }
+    };
+
+    void Reset();
+    template <typename EdgeFilter>
+    void Search(VertexId from, const std::optional<Weight>& limit, std::optional<VertexId> to, EdgeFilter skip_edge);
+
+    const Graph& graph_;
+    std::vector<Weight> weights_;
+    std::vector<std::optional<EdgeId>> prev_edges_;
+    std::vector<bool> reached_;
+    std::vector<bool> settled_;
+    std::vector<VertexId> touched_;
+    std::vector<VertexId> settled_order_;
+    std::vector<QueueItem> queue_;
+};
+
+template <typename Weight>
+ShortestPathSearch<Weight>::ShortestPathSearch(const Graph& graph)
+    : graph_(graph)
+    , weights_(graph.GetVertexCount())
+    , prev_edges_(graph.GetVertexCount())
+    , reached_(graph.GetVertexCount(), false)
+    , settled_(graph.GetVertexCount(), false) {
+}
+
+template <typename Weight>
+void ShortestPathSearch<Weight>::Reset() {
+    for (const VertexId vertex : touched_) {
+        reached_[vertex] = false;
+        settled_[vertex] = false;
+        prev_edges_[vertex].reset();
+    }
+    touched_.clear();
+    settled_order_.clear();
+}
+
+template <typename Weight>
+void ShortestPathSearch<Weight>::Run(VertexId from, const std::optional<Weight>& limit) {
+    Search(from, limit, std::nullopt, [](EdgeId) {
+        return false;
+    });
+}
+
+template <typename Weight>
+template <typename EdgeFilter>
+void ShortestPathSearch<Weight>::Run(VertexId from, VertexId to, EdgeFilter skip_edge) {
+    Search(from, std::nullopt, to, std::move(skip_edge));
+}
+
+template <typename Weight>
+template <typename EdgeFilter>
+void ShortestPathSearch<Weight>::Search(VertexId from, const std::optional<Weight>& limit, std::optional<VertexId> to,
+                                        EdgeFilter skip_edge) {
+    Reset();
+    // Куча строится поверх queue_, чтобы её память сохранялась между запусками
+    queue_.clear();
+    const QueueCompare compare;
+
+    weights_.at(from) = Weight{};
+    reached_[from] = true;
+    touched_.push_back(from);
+    queue_.push_back({weights_[from], from});
+    while (!queue_.empty()) {
+        std::pop_heap(queue_.begin(), queue_.end(), compare);
+        const QueueItem item = std::move(queue_.back());
+        queue_.pop_back();
+        if (settled_[item.vertex] || weights_[item.vertex] < item.weight) {
+            continue;
+        }
+        if (limit && *limit < item.weight) {
+            break;
+        }
+        settled_[item.vertex] = true;
+        settled_order_.push_back(item.vertex);
+        if (to && item.vertex == *to) {
+            break;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (settled_[edge.to] || skip_edge(edge_id)) {
+                continue;
+            }
+            Weight candidate = item.weight + edge.weight;
+            if (limit && *limit < candidate) {
+                continue;
+            }
+            if (!reached_[edge.to] || candidate < weights_[edge.to]) {
+                if (!reached_[edge.to]) {
+                    reached_[edge.to] = true;
+                    touched_.push_back(edge.to);
+                }
+                weights_[edge.to] = candidate;
+                prev_edges_[edge.to] = edge_id;
+                queue_.push_back({std::move(candidate), edge.to});
+                std::push_heap(queue_.begin(), queue_.end(), compare);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+bool ShortestPathSearch<Weight>::IsReached(VertexId vertex) const {
+    return settled_.at(vertex);
+}
+
+template <typename Weight>
+const Weight& ShortestPathSearch<Weight>::GetWeight(VertexId vertex) const {
+    return weights_.at(vertex);
+}
+
+template <typename Weight>
+std::optional<EdgeId> ShortestPathSearch<Weight>::GetPrevEdge(VertexId vertex) const {
+    return prev_edges_.at(vertex);
+}
+
+template <typename Weight>
+const std::vector<VertexId>& ShortestPathSearch<Weight>::GetSettledVertices() const {
+    return settled_order_;
+}
+
+template <typename Weight>
+std::vector<EdgeId> ShortestPathSearch<Weight>::GetRouteEdges(VertexId to) const {
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = prev_edges_.at(to); edge_id;
+         edge_id = prev_edges_[graph_.GetEdge(*edge_id).from]) {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+}  // namespace graph
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace flat {
+
+// Финализатор MurmurHash3: перемешивает все биты ключа, поэтому соседние
+// идентификаторы попадают в далёкие друг от друга ячейки
+inline uint64_t MixHash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// Хеш-таблица с открытой адресацией и линейным пробированием для 64-битных ключей.
+// Ключи и значения лежат в одном непрерывном массиве, поиск не ходит по указателям.
+// Значение ключа EMPTY_KEY зарезервировано под пустые ячейки. Удаления не поддерживаются
+template <typename Value>
+class U64HashMap {
+public:
+    static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+    // Готовит таблицу к count элементам без перестроений
+    void Reserve(size_t count) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity * MAX_LOAD_NUM < count * MAX_LOAD_DEN) {
+            capacity *= 2;
+        }
+        if (capacity > slots_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    // Записывает значение по ключу, заменяя прежнее
+    void Set(uint64_t key, Value value) {
+        if (key == EMPTY_KEY) {
+            throw std::invalid_argument("Reserved hash map key");
+        }
+        if ((size_ + 1) * MAX_LOAD_DEN > slots_.size() * MAX_LOAD_NUM) {
+            Rehash(slots_.empty() ? MIN_CAPACITY : slots_.size() * 2);
+        }
+        Slot& slot = slots_[FindSlot(key)];
+        if (slot.key == EMPTY_KEY) {
+            slot.key = key;
+            ++size_;
+        }
+        slot.value = std::move(value);
+    }
+
+    // Указатель на значение или nullptr, если ключа нет
+    const Value* Find(uint64_t key) const {
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        const Slot& slot = slots_[FindSlot(key)];
+        return slot.key == key ? &slot.value : nullptr;
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    struct Slot {
+        uint64_t key = EMPTY_KEY;
+        Value value{};
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+    // Таблица заполняется не больше чем на 3/4
+    static constexpr size_t MAX_LOAD_NUM = 3;
+    static constexpr size_t MAX_LOAD_DEN = 4;
+
+    // Ячейка с ключом key либо пустая ячейка, в которую его следует записать
+    size_t FindSlot(uint64_t key) const {
+        const size_t mask = slots_.size() - 1;
+        size_t index = MixHash(key) & mask;
+        while (slots_[index].key != key && slots_[index].key != EMPTY_KEY) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(slots_);
+        for (Slot& slot : old_slots) {
+            if (slot.key != EMPTY_KEY) {
+                slots_[FindSlot(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+}  // namespace flat
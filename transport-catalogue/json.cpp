@@ -1,5 +1,8 @@
 #include "json.h"
+#include "metrics.h"
 
+#include <array>
+#include <charconv>
 #include <iterator>
 
 namespace json {
@@ -7,8 +10,8 @@ namespace json {
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+Node LoadNode(std::istream& input, std::pmr::memory_resource* resource);
+String LoadString(std::istream& input, std::pmr::memory_resource* resource);
 
 std::string LoadLiteral(std::istream& input) {
     std::string s;
@@ -18,14 +21,14 @@ std::string LoadLiteral(std::istream& input) {
     return s;
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+Node LoadArray(std::istream& input, std::pmr::memory_resource* resource) {
+    Array result(resource);
 
     for (char c; input >> c && c != ']';) {
         if (c != ',') {
             input.putback(c);
         }
-        result.push_back(LoadNode(input));
+        result.push_back(LoadNode(input, resource));
     }
     if (!input) {
         throw ParsingError("Array parsing error"s);
@@ -33,17 +36,17 @@ Node LoadArray(std::istream& input) {
     return Node(std::move(result));
 }
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+Node LoadDict(std::istream& input, std::pmr::memory_resource* resource) {
+    Dict dict(resource);
 
     for (char c; input >> c && c != '}';) {
         if (c == '"') {
-            std::string key = LoadString(input).AsString();
+            String key = LoadString(input, resource);
             if (input >> c && c == ':') {
                 if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
+                    throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
                 }
-                dict.emplace(std::move(key), LoadNode(input));
+                dict.emplace(std::move(key), LoadNode(input, resource));
             } else {
                 throw ParsingError(": is expected but '"s + c + "' has been found"s);
             }
@@ -57,10 +60,11 @@ Node LoadDict(std::istream& input) {
     return Node(std::move(dict));
 }
 
-Node LoadString(std::istream& input) {
+// Строка читается сразу в память из resource
+String LoadString(std::istream& input, std::pmr::memory_resource* resource) {
     auto it = std::istreambuf_iterator<char>(input);
     auto end = std::istreambuf_iterator<char>();
-    std::string s;
+    String s(resource);
     while (true) {
         if (it == end) {
             throw ParsingError("String parsing error");
@@ -102,7 +106,7 @@ Node LoadString(std::istream& input) {
         ++it;
     }
 
-    return Node(std::move(s));
+    return s;
 }
 
 Node LoadBool(std::istream& input) {
@@ -125,31 +129,43 @@ Node LoadNull(std::istream& input) {
 }
 
 Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+    // Число читается напрямую из буфера потока, минуя проверки istream на каждый символ.
+    // Координаты с полной точностью длиннее SSO-буфера строки, поэтому parsed_num
+    // размещается в буфере на стеке и обращается к куче только для очень длинных чисел
+    std::streambuf& buf = *input.rdbuf();
+    std::array<char, 128> stack_buffer;
+    std::pmr::monotonic_buffer_resource stack_resource(stack_buffer.data(), stack_buffer.size());
+    String parsed_num(&stack_resource);
+
+    auto peek = [&buf] {
+        return buf.sgetc();
+    };
 
     // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
+    auto read_char = [&parsed_num, &buf, &input] {
+        const int ch = buf.sbumpc();
+        if (ch == std::char_traits<char>::eof()) {
+            input.setstate(std::ios::eofbit | std::ios::failbit);
             throw ParsingError("Failed to read number from stream"s);
         }
+        parsed_num += static_cast<char>(ch);
     };
 
     // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    auto read_digits = [peek, read_char] {
+        if (!std::isdigit(peek())) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
+        while (std::isdigit(peek())) {
             read_char();
         }
     };
 
-    if (input.peek() == '-') {
+    if (peek() == '-') {
         read_char();
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
+    if (peek() == '0') {
         read_char();
         // После 0 в JSON не могут идти другие цифры
     } else {
@@ -158,50 +174,51 @@ Node LoadNumber(std::istream& input) {
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
+    if (peek() == '.') {
         read_char();
         read_digits();
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
+    if (int ch = peek(); ch == 'e' || ch == 'E') {
         read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
+        if (ch = peek(); ch == '+' || ch == '-') {
             read_char();
         }
         read_digits();
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
-            }
+    const char* first = parsed_num.data();
+    const char* last = first + parsed_num.size();
+    if (is_int) {
+        // Сначала пробуем преобразовать строку в int. При переполнении
+        // код ниже преобразует строку в double
+        int int_value = 0;
+        if (auto [ptr, ec] = std::from_chars(first, last, int_value); ec == std::errc{} && ptr == last) {
+            return int_value;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
     }
+    double double_value = 0;
+    if (auto [ptr, ec] = std::from_chars(first, last, double_value); ec != std::errc{} || ptr != last) {
+        throw ParsingError("Failed to convert "s + std::string(parsed_num) + " to number"s);
+    }
+    return double_value;
 }
 
-Node LoadNode(std::istream& input) {
+Node LoadNode(std::istream& input, std::pmr::memory_resource* resource) {
     char c;
     if (!(input >> c)) {
         throw ParsingError("Unexpected EOF"s);
     }
     switch (c) {
         case '[':
-            return LoadArray(input);
+            return LoadArray(input, resource);
         case '{':
-            return LoadDict(input);
+            return LoadDict(input, resource);
         case '"':
-            return LoadString(input);
+            return LoadString(input, resource);
         case 't':
             // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
             // подсказкой компилятору и человеку, что здесь программист явно задумывал
@@ -245,35 +262,63 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
+// Выводит символы [begin, end) в строку JSON с экранированием, участки без особых символов - одной записью
+void PrintEscaped(const char* begin, const char* end, std::ostream& out) {
+    const char* run = begin;
+    for (const char* it = begin; it != end; ++it) {
+        std::string_view escaped;
+        switch (*it) {
             case '\r':
-                out << "\\r"sv;
+                escaped = "\\r"sv;
                 break;
             case '\n':
-                out << "\\n"sv;
+                escaped = "\\n"sv;
                 break;
             case '\t':
-                out << "\\t"sv;
+                escaped = "\\t"sv;
                 break;
+            // Символы " и \ выводятся как \" или \\, соответственно
             case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
+                escaped = "\\\""sv;
+                break;
             case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
+                escaped = "\\\\"sv;
                 break;
+            default:
+                continue;
         }
+        out.write(run, it - run);
+        out.write(escaped.data(), escaped.size());
+        run = it + 1;
     }
+    out.write(run, end - run);
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
+    out.put('"');
+    PrintEscaped(value.data(), value.data() + value.size(), out);
     out.put('"');
 }
 
+// Числа форматируются через to_chars без участия локали потока.
+// Для double сохраняется формат operator<< по умолчанию: %g с точностью 6
+template <>
+void PrintValue<int>(const int& value, const PrintContext& ctx) {
+    std::array<char, 16> buffer;
+    const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    ctx.out.write(buffer.data(), ptr - buffer.data());
+}
+
+template <>
+void PrintValue<double>(const double& value, const PrintContext& ctx) {
+    std::array<char, 32> buffer;
+    const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
+                                         std::chars_format::general, 6);
+    ctx.out.write(buffer.data(), ptr - buffer.data());
+}
+
 template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
+void PrintValue<String>(const String& value, const PrintContext& ctx) {
     PrintString(value, ctx.out);
 }
 
@@ -343,12 +388,59 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+EscapedStringWriter::Buffer::Buffer(std::ostream& output)
+    : output_(output) {
+    setp(data_, data_ + sizeof(data_));
+}
+
+EscapedStringWriter::Buffer::int_type EscapedStringWriter::Buffer::overflow(int_type ch) {
+    Flush();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int EscapedStringWriter::Buffer::sync() {
+    Flush();
+    return output_ ? 0 : -1;
+}
+
+void EscapedStringWriter::Buffer::Flush() {
+    PrintEscaped(pbase(), pptr(), output_);
+    setp(data_, data_ + sizeof(data_));
+}
+
+EscapedStringWriter::EscapedStringWriter(std::ostream& output)
+    : std::ostream(nullptr)
+    , buffer_(output) {
+    rdbuf(&buffer_);
+}
+
+EscapedStringWriter::~EscapedStringWriter() {
+    buffer_.pubsync();
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    TC_METRICS_SCOPE("json_load");
+    auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+    Node root = LoadNode(input, arena.get());
+    return Document{std::move(arena), std::move(root)};
+}
+
+Document Load(std::istream& input, std::pmr::memory_resource* resource) {
+    TC_METRICS_SCOPE("json_load");
+    return Document{LoadNode(input, resource)};
 }
 
 void Print(const Document& doc, std::ostream& output) {
+    TC_METRICS_SCOPE("json_print");
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+void Print(const Node& node, std::ostream& output, int indent) {
+    PrintNode(node, PrintContext{output, 4, indent});
+}
+
 }  // namespace json
\ No newline at end of file
@@ -2,15 +2,21 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+// Контейнеры, ключи словарей и строки используют polymorphic_allocator: по умолчанию
+// память берётся из кучи, но дерево целиком можно разместить в арене (см. Document и Load)
+using String = std::pmr::string;
+using Dict = std::pmr::map<String, Node, std::less<>>;
+using Array = std::pmr::vector<Node>;
 
 class ParsingError : public std::runtime_error {
 public:
@@ -18,12 +24,16 @@ public:
 };
 
 class Node final
-    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String> {
 public:
     using variant::variant;
     using Value = variant;
     
     Node(Value value) : variant(std::move(value)) {}
+    // Строка копируется в память из resource
+    Node(std::string_view value, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : variant(std::in_place_type<String>, value, resource) {}
+    Node(const std::string& value) : Node(std::string_view(value)) {}
 
     bool IsInt() const {
         return std::holds_alternative<int>(*this);
@@ -77,17 +87,33 @@ public:
 
         return std::get<Array>(*this);
     }
+    Array& AsArray() {
+        using namespace std::literals;
+        if (!IsArray()) {
+            throw std::logic_error("Not an array"s);
+        }
+
+        return std::get<Array>(*this);
+    }
 
     bool IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<String>(*this);
     }
-    const std::string& AsString() const {
+    const String& AsString() const {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
         }
 
-        return std::get<std::string>(*this);
+        return std::get<String>(*this);
+    }
+    String& AsString() {
+        using namespace std::literals;
+        if (!IsString()) {
+            throw std::logic_error("Not a string"s);
+        }
+
+        return std::get<String>(*this);
     }
 
     bool IsDict() const {
@@ -101,6 +127,14 @@ public:
 
         return std::get<Dict>(*this);
     }
+    Dict& AsDict() {
+        using namespace std::literals;
+        if (!IsDict()) {
+            throw std::logic_error("Not a dict"s);
+        }
+
+        return std::get<Dict>(*this);
+    }
 
     bool operator==(const Node& rhs) const {
         return GetValue() == rhs.GetValue();
@@ -125,11 +159,24 @@ public:
         : root_(std::move(root)) {
     }
 
+    // Документ, узлы которого размещены в арене arena. Арена освобождается
+    // одним вызовом вместе с документом
+    Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena, Node root)
+        : arena_(std::move(arena))
+        , root_(std::move(root)) {
+    }
+
     const Node& GetRoot() const {
         return root_;
     }
 
+    Node& GetRoot() {
+        return root_;
+    }
+
 private:
+    // Арена объявлена раньше корня, чтобы пережить его при разрушении документа
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
     Node root_;
 };
 
@@ -141,8 +188,40 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Поток, содержимое которого выводится в output как содержимое строки JSON: с экранированием,
+// но без кавычек. Позволяет печатать длинные строки по частям, не собирая их целиком
+class EscapedStringWriter : public std::ostream {
+public:
+    explicit EscapedStringWriter(std::ostream& output);
+    ~EscapedStringWriter() override;
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        explicit Buffer(std::ostream& output);
+
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+
+    private:
+        void Flush();
+
+        std::ostream& output_;
+        char data_[4096];
+    };
+
+    Buffer buffer_;
+};
+
+// Узлы загруженного документа размещаются в его собственной арене
 Document Load(std::istream& input);
+// Узлы размещаются в resource, который должен пережить документ
+Document Load(std::istream& input, std::pmr::memory_resource* resource);
 
 void Print(const Document& doc, std::ostream& output);
+// Печатает узел так, как он выглядит внутри документа на уровне вложенности с отступом indent.
+// Первая строка узла печатается без отступа
+void Print(const Node& node, std::ostream& output, int indent);
 
 } 
\ No newline at end of file
@@ -7,6 +7,8 @@ namespace json {
 
 Builder::Builder() : root_(), nodes_stack_{&root_} {}
 
+Builder::Builder(std::pmr::memory_resource* resource) : resource_(resource), root_(), nodes_stack_{&root_} {}
+
 Node Builder::Build(){
     if(root_.IsNull() || nodes_stack_.size() > 1){
         throw std::logic_error("Attempt to build JSON which isn't initialized");
@@ -14,9 +16,9 @@ Node Builder::Build(){
     return std::move(root_);
 }
 
-KeyItemContext Builder::Key(std::string key){
+KeyItemContext Builder::Key(std::string_view key){
     if(!current_key_.has_value() && nodes_stack_.back()->IsDict()){
-        current_key_ = std::move(key);
+        current_key_.emplace(key, resource_);
     }
     else{
         throw std::logic_error("Error setting Key");
@@ -24,70 +26,63 @@ KeyItemContext Builder::Key(std::string key){
     return *this;
 }
 
-Builder& Builder::Value(Node::Value value){
-    if(root_.IsNull()){
-        root_.GetValue() = std::move(value);
+Node& Builder::AddNode(Node::Value value, const char* error){
+    if(nodes_stack_.empty()){
+        throw std::logic_error(error);
+    }
+    Node& current = *nodes_stack_.back();
+    if(current.IsNull()){
+        current.GetValue() = std::move(value);
+        return current;
     }
-    else if(nodes_stack_.back()->IsDict()){
+    if(current.IsDict()){
         if(!current_key_.has_value()){
             throw std::logic_error("No key for Dict");
         }
-        std::get<json::Dict>(nodes_stack_.back()->GetValue()).emplace(current_key_.value(), value);
+        Node& node = std::get<json::Dict>(current.GetValue()).emplace(std::move(*current_key_), std::move(value)).first->second;
         current_key_.reset();
+        return node;
     }
-    else if(nodes_stack_.back()->IsArray()){
-        std::get<json::Array>(nodes_stack_.back()->GetValue()).emplace_back(std::move(value));
-    }
-    else{
-        throw std::logic_error("No containers for Value");
+    if(current.IsArray()){
+        return std::get<json::Array>(current.GetValue()).emplace_back(std::move(value));
     }
+    throw std::logic_error(error);
+}
+
+Builder& Builder::Value(Node::Value value){
+    AddNode(std::move(value), "No containers for Value");
     return *this;
 }
 
+Builder& Builder::Value(std::string_view value){
+    return Value(std::move(Node(value, resource_).GetValue()));
+}
+
+Builder& Builder::Value(const std::string& value){
+    return Value(std::string_view(value));
+}
+
+Builder& Builder::Value(const char* value){
+    return Value(std::string_view(value));
+}
+
+Builder& Builder::Value(Builder&& child){
+    return Value(std::move(child.Build().GetValue()));
+}
+
 DictItemContext Builder::StartDict(){
-    if(nodes_stack_.back()->IsNull()){
-        nodes_stack_.back()->GetValue() = Dict{};
-    }
-    else if(nodes_stack_.back()->IsDict()){
-        if(!current_key_.has_value()){
-            throw std::logic_error("No key for Dict");
-        }
-        std::get<json::Dict>(nodes_stack_.back()->GetValue()).emplace(current_key_.value(), Dict{});
-        const json::Node* node = &nodes_stack_.back()->AsDict().at(current_key_.value());
-        nodes_stack_.push_back(const_cast<Node*>(node));
-        current_key_.reset();
-    }
-    else if(nodes_stack_.back()->IsArray()){
-        auto& temp_arr = std::get<json::Array>(nodes_stack_.back()->GetValue());
-        temp_arr.emplace_back(Dict{});
-        nodes_stack_.emplace_back(&temp_arr.back());
-    }
-    else{
-        throw std::logic_error("Cant start Dict");
+    Node& node = AddNode(Dict(resource_), "Cant start Dict");
+    if(&node != &root_){
+        nodes_stack_.push_back(&node);
     }
     return *this;
 }
 
-ArrayItemContext Builder::StartArray(){
-    if(nodes_stack_.back()->IsNull()){
-        nodes_stack_.back()->GetValue() = Array{};
-    }
-    else if(nodes_stack_.back()->IsDict()){
-        if(!current_key_.has_value()){
-            throw std::logic_error("No key for Dict");
-        }
-        std::get<json::Dict>(nodes_stack_.back()->GetValue()).emplace(current_key_.value(), Array{});
-        const json::Node* node = &nodes_stack_.back()->AsDict().at(current_key_.value());
-        nodes_stack_.push_back(const_cast<Node*>(node));
-        current_key_.reset();
-    }
-    else if(nodes_stack_.back()->IsArray()){
-        auto& temp_arr = std::get<json::Array>(nodes_stack_.back()->GetValue());
-        temp_arr.emplace_back(Array{});
-        nodes_stack_.emplace_back(&temp_arr.back());
-    }
-    else{
-        throw std::logic_error("Cant start Array");
+ArrayItemContext Builder::StartArray(size_t capacity){
+    Node& node = AddNode(Array(resource_), "Cant start Array");
+    std::get<json::Array>(node.GetValue()).reserve(capacity);
+    if(&node != &root_){
+        nodes_stack_.push_back(&node);
     }
     return *this;
 }
@@ -114,7 +109,7 @@ ArrayItemContext::ArrayItemContext(Builder& builder) : builder_(builder) {}
 
 KeyItemContext::KeyItemContext(Builder& builder) : builder_(builder) {}
 
-KeyItemContext DictItemContext::Key(std::string key){
+KeyItemContext DictItemContext::Key(std::string_view key){
     return builder_.Key(key);
 }
 
@@ -122,10 +117,6 @@ Builder& DictItemContext::EndDict(){
     return builder_.EndDict();
 }
 
-ArrayItemContext ArrayItemContext::Value(Node::Value value){
-    return ArrayItemContext{builder_.Value(value)};
-}
-
 DictItemContext ArrayItemContext::StartDict(){
     return builder_.StartDict();
 }
@@ -134,19 +125,15 @@ Builder& ArrayItemContext::EndArray(){
     return builder_.EndArray();
 }
 
-ArrayItemContext ArrayItemContext::StartArray(){
-    return builder_.StartArray();
-}
-
-DictItemContext KeyItemContext::Value(Node::Value value){
-    return DictItemContext{builder_.Value(value)};
+ArrayItemContext ArrayItemContext::StartArray(size_t capacity){
+    return builder_.StartArray(capacity);
 }
 
 DictItemContext KeyItemContext::StartDict(){
     return builder_.StartDict();
 }
 
-ArrayItemContext KeyItemContext::StartArray(){
-    return builder_.StartArray();
+ArrayItemContext KeyItemContext::StartArray(size_t capacity){
+    return builder_.StartArray(capacity);
 }
 }
\ No newline at end of file
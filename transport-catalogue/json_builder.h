@@ -3,6 +3,9 @@
 #include "json.h"
 
 #include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace json {
 
@@ -13,25 +16,39 @@ class DictItemContext;
 class Builder {
 public:
     Builder();
-    KeyItemContext Key(std::string key);
+    // Словари, массивы и строки строящегося дерева размещаются в resource
+    explicit Builder(std::pmr::memory_resource* resource);
+    KeyItemContext Key(std::string_view key);
     Builder& Value(Node::Value value);
+    // Строка копируется сразу в память из resource
+    Builder& Value(std::string_view value);
+    Builder& Value(const std::string& value);
+    Builder& Value(const char* value);
+    // Добавляет значение, построенное другим построителем, без копирования
+    Builder& Value(Builder&& child);
     DictItemContext StartDict();
-    ArrayItemContext StartArray();
+    // capacity - ожидаемое число элементов массива, под которое память выделяется сразу
+    ArrayItemContext StartArray(size_t capacity = 0);
     Builder& EndDict();
     Builder& EndArray();
     Node Build();
     Node GetNode(Node::Value value);
 
 private:
+    // Помещает value в корень, в словарь по текущему ключу или в конец массива и возвращает
+    // добавленный узел. Если добавить некуда, бросает std::logic_error с текстом error
+    Node& AddNode(Node::Value value, const char* error);
+
+    std::pmr::memory_resource* resource_ = std::pmr::get_default_resource();
     Node root_ = nullptr;
     std::vector<Node*> nodes_stack_;
-    std::optional<std::string> current_key_;
+    std::optional<String> current_key_;
 };
 
 class DictItemContext{
 public:
     DictItemContext(Builder& builder);
-    KeyItemContext Key(std::string key);
+    KeyItemContext Key(std::string_view key);
     Builder& EndDict();
 private:
     Builder& builder_;
@@ -40,10 +57,14 @@ private:
 class ArrayItemContext{
 public:
     ArrayItemContext(Builder& builder);
-    ArrayItemContext Value(Node::Value value);
+    // Принимает всё, что принимает Builder::Value
+    template <typename T>
+    ArrayItemContext Value(T&& value){
+        return ArrayItemContext{builder_.Value(std::forward<T>(value))};
+    }
     DictItemContext StartDict();
     Builder& EndArray();
-    ArrayItemContext StartArray();
+    ArrayItemContext StartArray(size_t capacity = 0);
 private:
     Builder& builder_;
 };
@@ -51,9 +72,13 @@ private:
 class KeyItemContext{
 public:
     KeyItemContext(Builder& builder);
-    DictItemContext Value(Node::Value value);
+    // Принимает всё, что принимает Builder::Value
+    template <typename T>
+    DictItemContext Value(T&& value){
+        return DictItemContext{builder_.Value(std::forward<T>(value))};
+    }
     DictItemContext StartDict();
-    ArrayItemContext StartArray();
+    ArrayItemContext StartArray(size_t capacity = 0);
 private:
     Builder& builder_;
 };
@@ -1,5 +1,8 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "metrics.h"
+#include "parallel.h"
+#include "png.h"
 #include <sstream>
 json::Node JsonReader::GetBaseRequests(){
     auto it = document_.GetRoot().AsDict().find("base_requests");
@@ -21,39 +24,99 @@ json::Node JsonReader::GetRoutingSettings(){
     return it != document_.GetRoot().AsDict().end() ? it->second : nullptr;
 }
 
-void JsonReader::FillCatalogue(tc::TransportCatalogue& catalogue){
-    json::Array request_values = GetBaseRequests().AsArray();
-    FillStops(request_values,catalogue);
-    SetDistancesToStops(request_values,catalogue);
-    FillBuses(request_values,catalogue);
+json::Node JsonReader::GetOutputSettings(){
+    auto it = document_.GetRoot().AsDict().find("output_settings");
+    return it != document_.GetRoot().AsDict().end() ? it->second : nullptr;
+}
+
+namespace {
+// Меньше запросов в куске не имеет смысла отдавать отдельному потоку
+constexpr size_t MIN_INGEST_CHUNK = 2048;
+
+struct IngestChunk{
+    std::vector<StopInfo> stops;
+    std::vector<BusInfo> buses;
+    size_t distance_count = 0;
+};
 }
 
-void JsonReader::FillStops(json::Array request_values, tc::TransportCatalogue& catalogue){
-    for (const auto& value : request_values){
-        if (value.AsDict().at("type").AsString() == "Stop"){
-            StopInfo stop_info = GetStopInfo(value.AsDict());
-            catalogue.AddStop(stop_info.stop_name, stop_info.cords);
+void JsonReader::FillCatalogue(tc::TransportCatalogue& catalogue){
+    TC_METRICS_SCOPE("fill_catalogue");
+    auto it = document_.GetRoot().AsDict().find("base_requests");
+    if(it == document_.GetRoot().AsDict().end()){
+        return;
+    }
+    const json::Array& request_values = it->second.AsArray();
+
+    // Записи об остановках и маршрутах разбираются параллельно по непрерывным кускам массива.
+    // Каждый поток пишет только в свой кусок, а склейка идёт в исходном порядке запросов,
+    // поэтому справочник получается тем же, что и при последовательной загрузке
+    std::vector<IngestChunk> chunks(par::GetChunkCount(request_values.size(), MIN_INGEST_CHUNK));
+    par::ForEachChunk(request_values.size(), MIN_INGEST_CHUNK, [&](size_t chunk_index, size_t begin, size_t end){
+        IngestChunk& chunk = chunks[chunk_index];
+        for (size_t i = begin; i < end; ++i){
+            const json::Dict& request = request_values[i].AsDict();
+            const auto& type = request.at("type").AsString();
+            if (type == "Stop"){
+                chunk.stops.push_back(GetStopInfo(request));
+                chunk.distance_count += chunk.stops.back().stops_distances.size();
+            }
+            else if (type == "Bus"){
+                chunk.buses.push_back(GetBusInfo(request));
+            }
         }
+    });
+
+    size_t stop_count = 0;
+    size_t bus_count = 0;
+    size_t distance_count = 0;
+    for (const auto& chunk : chunks){
+        stop_count += chunk.stops.size();
+        bus_count += chunk.buses.size();
+        distance_count += chunk.distance_count;
     }
-}
+    catalogue.Reserve(stop_count, bus_count, distance_count);
 
-void JsonReader::SetDistancesToStops(json::Array request_values, tc::TransportCatalogue& catalogue){
-    for (const auto& value : request_values){
-        if (value.AsDict().at("type").AsString() == "Stop"){
-            StopInfo stop_info = GetStopInfo(value.AsDict());
+    // Расстояния и маршруты ссылаются на остановки по имени, поэтому добавляются
+    // после того, как все остановки попали в справочник
+    std::vector<DistanceInfo> distances;
+    distances.reserve(distance_count);
+    for (auto& chunk : chunks){
+        for (auto& stop_info : chunk.stops){
+            const tc::Stop* stop = catalogue.AddStop(std::move(stop_info.stop_name), stop_info.cords);
             for (const auto& [another_stop, distance] : stop_info.stops_distances){
-                catalogue.SetDistanceToStops(catalogue.FindStopByName(stop_info.stop_name), catalogue.FindStopByName(another_stop), distance);
+                distances.push_back({stop, another_stop, distance});
             }
         }
     }
+    SetDistancesToStops(distances, catalogue);
+    for (auto& chunk : chunks){
+        FillBuses(chunk.buses, catalogue);
+    }
+}
+
+void JsonReader::SetDistancesToStops(const std::vector<DistanceInfo>& distances, tc::TransportCatalogue& catalogue){
+    // Поиск остановок по имени только читает справочник и выполняется параллельно,
+    // запись расстояний остаётся последовательной
+    std::vector<const tc::Stop*> destinations(distances.size());
+    par::ForEachChunk(distances.size(), MIN_INGEST_CHUNK, [&](size_t, size_t begin, size_t end){
+        for (size_t i = begin; i < end; ++i){
+            destinations[i] = catalogue.FindStopByName(distances[i].to);
+        }
+    });
+    // Расстояния до остановок, которых нет в base_requests, пропускаются
+    for (size_t i = 0; i < distances.size(); ++i){
+        if (destinations[i]){
+            catalogue.SetDistanceToStops(distances[i].from, destinations[i], distances[i].distance);
+        }
+    }
 }
 
-void JsonReader::FillBuses(json::Array request_values, tc::TransportCatalogue& catalogue){
-    for (auto& value : request_values){
-        if (value.AsDict().at("type").AsString() == "Bus"){
-            const BusInfo bus_info = GetBusInfo(value.AsDict());
-            const std::vector<std::string> stops_vec(bus_info.stops.begin(), bus_info.stops.end());
-            catalogue.AddBus(bus_info.bus_name, stops_vec, bus_info.is_round);
+void JsonReader::FillBuses(std::vector<BusInfo>& buses, tc::TransportCatalogue& catalogue){
+    for (auto& bus_info : buses){
+        const tc::Bus* bus = catalogue.AddBus(std::move(bus_info.bus_name), std::move(bus_info.stops), bus_info.is_round);
+        if (!bus_info.departures.empty()){
+            catalogue.SetBusDepartures(bus, std::move(bus_info.departures));
         }
     }
 }
@@ -62,10 +125,10 @@ StopInfo JsonReader::GetStopInfo(const json::Dict& request) const {
     StopInfo stop_info;
     stop_info.stop_name = request.at("name").AsString();
     stop_info.cords = {request.at("latitude").AsDouble(), request.at("longitude").AsDouble()};
-    if(!request.at("road_distances").AsDict().empty()){
-        for (const auto&[stop, distance] : request.at("road_distances").AsDict()){
-            stop_info.stops_distances.emplace(stop, distance.AsInt());
-        }
+    const json::Dict& road_distances = request.at("road_distances").AsDict();
+    stop_info.stops_distances.reserve(road_distances.size());
+    for (const auto&[stop, distance] : road_distances){
+        stop_info.stops_distances.emplace_back(stop, distance.AsInt());
     }
     return stop_info;
 }
@@ -73,93 +136,407 @@ StopInfo JsonReader::GetStopInfo(const json::Dict& request) const {
 BusInfo JsonReader::GetBusInfo(const json::Dict& request) const{
     BusInfo bus_info;
     bus_info.bus_name = request.at("name").AsString();
-    for (const auto& stop_name : request.at("stops").AsArray()){
+    const json::Array& stops = request.at("stops").AsArray();
+    bus_info.stops.reserve(stops.size());
+    for (const auto& stop_name : stops){
         bus_info.stops.emplace_back(stop_name.AsString());
     }
     bus_info.is_round = request.at("is_roundtrip").AsBool();
+    // Расписание задаётся либо списком отправлений, либо первым и последним отправлением с интервалом
+    if (auto it = request.find("schedule"); it != request.end()){
+        const json::Dict& schedule = it->second.AsDict();
+        if (auto departures = schedule.find("departures"); departures != schedule.end()){
+            for (const auto& departure : departures->second.AsArray()){
+                bus_info.departures.push_back(departure.AsDouble());
+            }
+        }
+        else{
+            const double last_departure = schedule.at("last_departure").AsDouble();
+            const double interval = schedule.at("interval").AsDouble();
+            if (interval <= 0){
+                throw std::invalid_argument("Schedule interval should be positive");
+            }
+            for (double departure = schedule.at("first_departure").AsDouble(); departure <= last_departure; departure += interval){
+                bus_info.departures.push_back(departure);
+            }
+        }
+    }
     return bus_info;
 }
 
-void JsonReader::ApplyRequests(const json::Node& stat_request, const RequestHandler& handler){
-    json::Array result;
-    std::ofstream file("output.json");
+namespace {
+// Запросы Route с одной и той же остановкой отправления
+struct RouteGroup{
+    std::string from;
+    std::vector<std::string> to;
+    std::vector<std::string> keys;
+    std::vector<int> request_ids;
+};
+
+// Ответ пакета: построенный узел либо напечатанный ответ из кэша, в который при выводе
+// подставляется request_id. Карта не строится заранее, а выводится прямо в файл ответов
+struct ResponseSlot{
+    int request_id = 0;
+    ResponseCache::ResponsePtr response;
+    json::Node node;
+    bool map = false;
+};
+
+// Отступ ответов в массиве, который печатается на верхнем уровне output.json
+constexpr int RESPONSE_INDENT = 4;
+}
+
+ResponseCache::ResponsePtr JsonReader::StoreResponse(std::string key, const json::Node& response) {
+    std::ostringstream outs;
+    json::Print(response, outs, RESPONSE_INDENT);
+    auto cached = std::make_shared<const CachedResponse>(outs.str(), RESPONSE_INDENT);
+    response_cache_.Insert(std::move(key), cached);
+    return cached;
+}
+
+ResponseCacheStats JsonReader::GetResponseCacheStats() const{
+    return response_cache_.GetStats();
+}
+
+void JsonReader::ApplyRequests(const json::Node& stat_request, const RequestHandler& handler,
+                               const OutputSettings& output_settings){
+    // Все ответы пакета живут в одной арене и освобождаются разом после вывода
+    std::pmr::monotonic_buffer_resource arena;
+    std::vector<ResponseSlot> slots;
+    slots.reserve(stat_request.AsArray().size());
+    response_cache_.SetVersion(handler.GetCatalogueVersion());
+
+    // Ответы на запросы Stop, Bus и обычные Route зависят только от аргументов и берутся из кэша,
+    // если такой запрос уже встречался. Запросы Route без ответа группируются по остановке
+    // отправления и считаются одним заходом на группу, повторы внутри пакета считаются один раз
+    std::vector<RouteGroup> route_groups;
+    std::unordered_map<std::string_view, size_t> from_to_group;
+    std::unordered_map<std::string, std::vector<size_t>> pending_routes;
     for (auto& request : stat_request.AsArray()){
-        const auto& type_request = request.AsDict().at("type").AsString();
-        if(type_request == "Stop"){
-            auto res = GetStopRequest(request.AsDict(),handler).AsDict();
-            result.emplace_back(res);
-        }
-        if(type_request == "Bus"){
-            auto res = GetBusRequest(request.AsDict(), handler).AsDict();
-            result.emplace_back(res);
+        const json::Dict& request_dict = request.AsDict();
+        const auto& type_request = request_dict.at("type").AsString();
+        if(type_request == "Stop" || type_request == "Bus"){
+            const int request_id = request_dict.at("id").AsInt();
+            std::string key = ResponseCache::MakeKey(type_request, {request_dict.at("name").AsString()});
+            ResponseCache::ResponsePtr response = response_cache_.Find(key);
+            if(!response){
+                response = StoreResponse(std::move(key), type_request == "Stop" ? GetStopRequest(request_dict, handler, &arena)
+                                                                                : GetBusRequest(request_dict, handler, &arena));
+            }
+            slots.push_back({request_id, std::move(response), nullptr});
         }
         if(type_request == "Map"){
-            auto res = GetMapRequest(request.AsDict(), handler).AsDict();
-            result.emplace_back(res);
+            slots.push_back({request_dict.at("id").AsInt(), nullptr, nullptr, true});
+        }
+        if(type_request == "Isochrone"){
+            slots.push_back({0, nullptr, GetIsochroneRequest(request_dict, handler, &arena)});
+        }
+        if(type_request == "Matrix"){
+            slots.push_back({0, nullptr, GetMatrixRequest(request_dict, handler, &arena)});
         }
-        if(type_request == "Route"){
-            auto res = GetRouteRequest(request.AsDict(), handler).AsDict();
-            result.emplace_back(res);
+        if(type_request == "Route" && request_dict.count("pareto") && request_dict.at("pareto").AsBool()){
+            slots.push_back({0, nullptr, GetParetoRouteRequest(request_dict, handler, &arena)});
+        }
+        else if(type_request == "Route" && request_dict.count("max_alternatives")){
+            slots.push_back({0, nullptr, GetAlternativeRoutesRequest(request_dict, handler, &arena)});
+        }
+        else if(type_request == "Route" && request_dict.count("departure_time")){
+            slots.push_back({0, nullptr, GetRouteRequest(request_dict, handler, &arena)});
+        }
+        else if(type_request == "Route"){
+            const int request_id = request_dict.at("id").AsInt();
+            const std::string_view from = request_dict.at("from").AsString();
+            const std::string_view to = request_dict.at("to").AsString();
+            std::string key = ResponseCache::MakeKey(type_request, {from, to});
+            slots.push_back({request_id, response_cache_.Find(key), nullptr});
+            if(slots.back().response){
+                continue;
+            }
+            auto [pending, first] = pending_routes.try_emplace(std::move(key));
+            pending->second.push_back(slots.size() - 1);
+            if(!first){
+                continue;
+            }
+            auto [it, inserted] = from_to_group.emplace(from, route_groups.size());
+            if(inserted){
+                route_groups.push_back({std::string(from), {}, {}, {}});
+            }
+            RouteGroup& group = route_groups[it->second];
+            group.to.emplace_back(to);
+            group.keys.push_back(pending->first);
+            group.request_ids.push_back(request_id);
         }
     }
-    json::Print(json::Document{result}, file);
+
+    for (const auto& group : route_groups){
+        TC_METRICS_SCOPE("stat_request_route_group");
+        const auto routes = handler.GetRoutes(group.from, group.to);
+        for (size_t i = 0; i < routes.size(); ++i){
+            const ResponseCache::ResponsePtr response =
+                StoreResponse(group.keys[i], GetRouteResponse(group.request_ids[i], routes[i], &arena));
+            for (const size_t slot : pending_routes.at(group.keys[i])){
+                slots[slot].response = response;
+            }
+        }
+    }
+
+    // Массив ответов печатается так же, как json::Print напечатал бы json::Array из них
+    TC_METRICS_SCOPE("stat_responses_print");
+    // Карта в пакете одна и та же, поэтому в отдельный файл она пишется один раз
+    std::string map_file;
+    WriteOutputFile("output.json", output_settings.compression, [&](std::ostream& out){
+        out << "[\n";
+        for (size_t i = 0; i < slots.size(); ++i){
+            if(i > 0){
+                out << ",\n";
+            }
+            out << std::string(RESPONSE_INDENT, ' ');
+            if(slots[i].response){
+                slots[i].response->Print(out, slots[i].request_id);
+            }
+            else if(slots[i].map && output_settings.map_files){
+                if(map_file.empty()){
+                    map_file = WriteMapFile(slots[i].request_id, handler, output_settings);
+                }
+                json::Print(json::Builder{}.StartDict().Key("request_id").Value(slots[i].request_id)
+                                           .Key("map_file").Value(map_file).EndDict().Build(), out, RESPONSE_INDENT);
+            }
+            else if(slots[i].map){
+                PrintMapResponse(slots[i].request_id, handler, out);
+            }
+            else{
+                json::Print(slots[i].node, out, RESPONSE_INDENT);
+            }
+        }
+        out << "\n]";
+    });
 }
 
 tc::RouterSettings JsonReader::GetRouterSettings(const json::Dict& router_settings){
     tc::RouterSettings settings;
     settings.bus_velocity = router_settings.at("bus_velocity").AsDouble() * 1000 / 60;
     settings.bus_wait_time = router_settings.at("bus_wait_time").AsInt();
+    if(auto it = router_settings.find("transfer_penalty"); it != router_settings.end()){
+        settings.transfer_penalty = it->second.AsDouble();
+    }
+    if(auto it = router_settings.find("route_cache_mb"); it != router_settings.end()){
+        settings.route_cache_mb = it->second.AsDouble();
+    }
+    if(auto it = router_settings.find("max_timetable_rides"); it != router_settings.end()){
+        settings.max_timetable_rides = static_cast<size_t>(std::max(1, it->second.AsInt()));
+    }
     return settings;
 }
 
-json::Node JsonReader::GetRouteRequest(const json::Dict& stat_request, const RequestHandler& handler) const{
-    json::Node result;
-    std::string stop_from = stat_request.at("from").AsString();
-    std::string stop_to = stat_request.at("to").AsString();
+OutputSettings JsonReader::SetOutputSettings(const json::Dict& output_settings){
+    OutputSettings settings;
+    if(auto it = output_settings.find("compression"); it != output_settings.end()){
+        const std::string compression(it->second.AsString());
+        if(compression == "gzip"){
+            settings.compression = OutputCompression::GZIP;
+        }
+        else if(compression != "none"){
+            throw std::invalid_argument("Unknown output compression: " + compression);
+        }
+    }
+    if(auto it = output_settings.find("map_files"); it != output_settings.end()){
+        settings.map_files = it->second.AsBool();
+    }
+    return settings;
+}
+
+json::Node JsonReader::GetRouteRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                       std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_route");
+    const std::string stop_from(stat_request.at("from").AsString());
+    const std::string stop_to(stat_request.at("to").AsString());
     int request_id = stat_request.at("id").AsInt();
-    const std::optional<std::vector<tc::RouterEdge>> route = handler.GetRoute(stop_from, stop_to);
+    if(auto it = stat_request.find("departure_time"); it != stat_request.end()){
+        return GetRouteResponse(request_id, handler.GetRoute(stop_from, stop_to, it->second.AsDouble()), resource);
+    }
+    return GetRouteResponse(request_id, handler.GetRoute(stop_from, stop_to), resource);
+}
+
+json::Node JsonReader::GetRouteResponse(int request_id, const std::optional<std::vector<tc::RouterEdge>>& route,
+                                        std::pmr::memory_resource* resource) const{
+    json::Node result;
     if (!route.has_value()){
-        result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+        result = json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
     }
     else{
-        int wait_time = handler.GetBusWaitTime();
-        json::Array items;
         double total_time = 0;
         for(const auto& edge : route.value()){
             total_time += edge.time;
-            json::Dict wait_item = json::Builder{}.StartDict()
-                                                .Key("type").Value("Wait")
-                                                .Key("stop_name").Value(edge.start_stop)
-                                                .Key("time").Value(wait_time)
-                                            .EndDict().Build().AsDict();
-            json::Dict bus_item = json::Builder{}.StartDict()
-                                                .Key("type").Value("Bus")
-                                                .Key("bus").Value(edge.bus)
-                                                .Key("span_count").Value(edge.stop_count)
-                                                .Key("time").Value(edge.time - wait_time)
-                                            .EndDict().Build().AsDict();
-            items.push_back(wait_item);
-            items.push_back(bus_item);
-        }
-        result = json::Builder{}.StartDict()
-                            .Key("request_id").Value(request_id)
-                            .Key("total_time").Value(total_time)
-                            .Key("items").Value(items)
-                        .EndDict().Build();
+        }
+        json::Builder builder{resource};
+        builder.StartDict().Key("request_id").Value(request_id).Key("total_time").Value(total_time).Key("items");
+        AddRouteItems(builder, *route);
+        result = builder.EndDict().Build();
     }
     return result;
 }
 
-json::Node JsonReader::GetBusRequest(const json::Dict& stat_request, const RequestHandler& handler) const{
+json::Node JsonReader::GetParetoRouteRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                             std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_route_pareto");
+    int request_id = stat_request.at("id").AsInt();
+    const std::vector<tc::RouteOption> options = handler.GetParetoRoutes(std::string(stat_request.at("from").AsString()),
+                                                                         std::string(stat_request.at("to").AsString()));
+    if(options.empty()){
+        return json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+    }
+    json::Builder builder{resource};
+    builder.StartDict()
+               .Key("request_id").Value(request_id)
+               .Key("preferred_option").Value(static_cast<int>(handler.SelectPreferredOption(options)))
+               .Key("options").StartArray(options.size());
+    for(const auto& option : options){
+        builder.StartDict().Key("total_time").Value(option.total_time).Key("transfer_count").Value(option.transfer_count).Key("items");
+        AddRouteItems(builder, option.edges);
+        builder.EndDict();
+    }
+    return builder.EndArray().EndDict().Build();
+}
+
+json::Node JsonReader::GetAlternativeRoutesRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                                   std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_route_alternatives");
+    int request_id = stat_request.at("id").AsInt();
+    const int max_alternatives = stat_request.at("max_alternatives").AsInt();
+    const std::vector<tc::RouteOption> options = handler.GetAlternativeRoutes(std::string(stat_request.at("from").AsString()),
+                                                                              std::string(stat_request.at("to").AsString()),
+                                                                              std::max(1, max_alternatives));
+    if(options.empty()){
+        return json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+    }
+    json::Builder builder{resource};
+    builder.StartDict().Key("request_id").Value(request_id).Key("alternatives").StartArray(options.size());
+    for(const auto& option : options){
+        builder.StartDict().Key("total_time").Value(option.total_time).Key("items");
+        AddRouteItems(builder, option.edges);
+        builder.EndDict();
+    }
+    return builder.EndArray().EndDict().Build();
+}
+
+void JsonReader::AddRouteItems(json::Builder& builder, const std::vector<tc::RouterEdge>& route) const{
+    builder.StartArray(route.size() * 2);
+    for(const auto& edge : route){
+        builder.StartDict()
+                   .Key("type").Value("Wait")
+                   .Key("stop_name").Value(edge.start_stop)
+                   .Key("time").Value(edge.wait_time)
+               .EndDict();
+        builder.StartDict()
+                   .Key("type").Value("Bus")
+                   .Key("bus").Value(edge.bus)
+                   .Key("span_count").Value(edge.stop_count)
+                   .Key("time").Value(edge.time - edge.wait_time)
+               .EndDict();
+    }
+    builder.EndArray();
+}
+
+json::Node JsonReader::GetIsochroneRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                           std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_isochrone");
+    int request_id = stat_request.at("id").AsInt();
+    // Начало задаётся остановкой либо координатами, от которых берётся ближайшая остановка
+    std::string stop_from;
+    if(auto it = stat_request.find("from"); it != stat_request.end()){
+        stop_from = it->second.AsString();
+    }
+    else if(const tc::Stop* nearest = handler.FindNearestStop({stat_request.at("latitude").AsDouble(),
+                                                                stat_request.at("longitude").AsDouble()})){
+        stop_from = nearest->stop_name;
+    }
+    if(!handler.CheckStop(stop_from)){
+        return json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+    }
+    const std::vector<tc::ReachableStop> reachable = handler.GetReachableStops(stop_from, stat_request.at("time").AsDouble());
+
+    json::Builder builder{resource};
+    builder.StartDict().Key("request_id").Value(request_id).Key("from").Value(stop_from).Key("stops").StartArray(reachable.size());
+    for(const auto& [stop_name, time] : reachable){
+        builder.StartDict().Key("stop_name").Value(stop_name).Key("time").Value(time).EndDict();
+    }
+    builder.EndArray();
+    if(auto it = stat_request.find("render"); it != stat_request.end() && it->second.AsBool()){
+        std::vector<std::string_view> stop_names;
+        stop_names.reserve(reachable.size());
+        for(const auto& stop : reachable){
+            stop_names.push_back(stop.stop_name);
+        }
+        std::ostringstream outs;
+        handler.RenderStopsOverlay(stop_names).Render(outs);
+        builder.Key("map").Value(outs.str());
+    }
+    return builder.EndDict().Build();
+}
+
+json::Node JsonReader::GetMatrixRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                        std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_matrix");
+    int request_id = stat_request.at("id").AsInt();
+    std::vector<std::string> stops_from;
+    std::vector<std::string> stops_to;
+    bool all_found = true;
+    for(const auto& stop : stat_request.at("from").AsArray()){
+        stops_from.emplace_back(stop.AsString());
+        all_found = all_found && handler.CheckStop(stops_from.back());
+    }
+    for(const auto& stop : stat_request.at("to").AsArray()){
+        stops_to.emplace_back(stop.AsString());
+        all_found = all_found && handler.CheckStop(stops_to.back());
+    }
+    if(!all_found){
+        return json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+    }
+    auto it = stat_request.find("transfers");
+    const bool with_transfers = it != stat_request.end() && it->second.AsBool();
+    const tc::TravelTimeMatrix matrix = handler.GetTravelTimes(stops_from, stops_to, with_transfers);
+
+    // Ячейки матрицы - простые числа в массивах строк, без словаря на каждую пару остановок
+    json::Array times(resource);
+    times.reserve(matrix.rows);
+    json::Array transfers(resource);
+    transfers.reserve(with_transfers ? matrix.rows : 0);
+    for(size_t row = 0; row < matrix.rows; ++row){
+        json::Array& times_row = std::get<json::Array>(times.emplace_back(json::Array(resource)).GetValue());
+        times_row.reserve(matrix.cols);
+        for(size_t col = 0; col < matrix.cols; ++col){
+            const auto& time = matrix.times[row * matrix.cols + col];
+            times_row.emplace_back(time.has_value() ? json::Node(*time) : json::Node(nullptr));
+        }
+        if(with_transfers){
+            json::Array& transfers_row = std::get<json::Array>(transfers.emplace_back(json::Array(resource)).GetValue());
+            transfers_row.reserve(matrix.cols);
+            for(size_t col = 0; col < matrix.cols; ++col){
+                const size_t cell = row * matrix.cols + col;
+                transfers_row.emplace_back(matrix.times[cell].has_value() ? json::Node(matrix.transfers[cell]) : json::Node(nullptr));
+            }
+        }
+    }
+    json::Builder builder{resource};
+    builder.StartDict().Key("request_id").Value(request_id).Key("total_time").Value(std::move(times));
+    if(with_transfers){
+        builder.Key("transfers").Value(std::move(transfers));
+    }
+    return builder.EndDict().Build();
+}
+
+json::Node JsonReader::GetBusRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                       std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_bus");
     json::Node result;
-    std::string bus_name  = stat_request.at("name").AsString();
+    const std::string bus_name(stat_request.at("name").AsString());
     int request_id  = stat_request.at("id").AsInt();
     if(!handler.CheckBus(bus_name)){
-        result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+        result = json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
     }
     else{
         const auto& bus_stat = handler.GetBusStat(bus_name);
-        result = json::Builder{}.StartDict()
+        result = json::Builder{resource}.StartDict()
                                     .Key("request_id").Value(request_id)
                                     .Key("curvature").Value(bus_stat->curvature)
                                     .Key("route_length").Value(bus_stat->route_length)
@@ -170,19 +547,21 @@ json::Node JsonReader::GetBusRequest(const json::Dict& stat_request, const Reque
     return result;
 }
 
-json::Node JsonReader::GetStopRequest(const json::Dict& stat_request, const RequestHandler& handler) const{
+json::Node JsonReader::GetStopRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                       std::pmr::memory_resource* resource) const{
+    TC_METRICS_SCOPE("stat_request_stop");
     json::Node result;
-    std::string stop_name = stat_request.at("name").AsString();
+    const std::string stop_name(stat_request.at("name").AsString());
     int request_id  = stat_request.at("id").AsInt();
     if(!handler.CheckStop(stop_name)){
-        result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
+        result = json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value("not found").EndDict().Build();
     }
     else{
-        json::Array bus_names;
+        json::Array bus_names(resource);
         for(auto& bus_number : handler.GetBusesByStop(stop_name)){
             bus_names.emplace_back(std::string(bus_number));
         }
-        result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("buses").Value(bus_names).EndDict().Build();
+        result = json::Builder{resource}.StartDict().Key("request_id").Value(request_id).Key("buses").Value(std::move(bus_names)).EndDict().Build();
     }
     return result;
 }
@@ -218,14 +597,26 @@ render::RenderSettings JsonReader::SetRenderSettings(const json::Dict& render_se
         render_object.underlayer_color = GetColor(color_variant);
     }
     else if(render_settings.at("underlayer_color").IsString()){
-        render_object.underlayer_color = render_settings.at("underlayer_color").AsString();
+        render_object.underlayer_color = std::string(render_settings.at("underlayer_color").AsString());
     }
 
     render_object.underlayer_width = render_settings.at("underlayer_width").AsDouble();
+    if(auto it = render_settings.find("output_format"); it != render_settings.end()){
+        const std::string format(it->second.AsString());
+        if(format == "png"){
+            render_object.format = render::MapFormat::PNG;
+        }
+        else if(format != "svg"){
+            throw std::invalid_argument("Unknown map output format: " + format);
+        }
+    }
+    if(auto it = render_settings.find("lod_tolerance"); it != render_settings.end()){
+        render_object.lod_tolerance = it->second.AsDouble();
+    }
 
     for(const auto& color : render_settings.at("color_palette").AsArray()){
         if(color.IsString()){
-            render_object.color_palette.push_back(color.AsString());
+            render_object.color_palette.push_back(std::string(color.AsString()));
         }
         else if (color.IsArray()){
             render_object.color_palette.push_back(GetColor(color.AsArray()));
@@ -235,12 +626,42 @@ render::RenderSettings JsonReader::SetRenderSettings(const json::Dict& render_se
     return render_object;
 }
 
-json::Node JsonReader::GetMapRequest(const json::Dict& stat_request, const RequestHandler& handler) const{
-    json::Node result;
-    int request_id = stat_request.at("id").AsInt();
-    std::ostringstream outs;
-    svg::Document render_map = handler.RenderMap();
-    render_map.Render(outs);
-    result = json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("map").Value(outs.str()).EndDict().Build();
-    return result;
+namespace {
+// Карта для ответа на запрос Map: текст SVG или ссылка data: с изображением PNG
+void PrintMap(const RequestHandler& handler, std::ostream& out){
+    if(handler.GetMapFormat() == render::MapFormat::PNG){
+        std::ostringstream png_out;
+        handler.RenderMapPng(png_out);
+        out << png::ToDataUri(png_out.str());
+    }
+    else{
+        handler.RenderMap(out);
+    }
+}
+}
+
+std::string JsonReader::WriteMapFile(int request_id, const RequestHandler& handler, const OutputSettings& output_settings) const{
+    TC_METRICS_SCOPE("stat_request_map");
+    // PNG уже сжат, поэтому пишется как есть
+    if(handler.GetMapFormat() == render::MapFormat::PNG){
+        return WriteOutputFile("map_" + std::to_string(request_id) + ".png", OutputCompression::NONE, [&handler](std::ostream& out){
+            handler.RenderMapPng(out);
+        });
+    }
+    return WriteOutputFile("map_" + std::to_string(request_id) + ".svg", output_settings.compression, [&handler](std::ostream& out){
+        handler.RenderMap(out);
+    });
+}
+
+void JsonReader::PrintMapResponse(int request_id, const RequestHandler& handler, std::ostream& out) const{
+    TC_METRICS_SCOPE("stat_request_map");
+    // Печать совпадает с json::Print для словаря {"map", "request_id"} на уровне ответов пакета
+    const std::string key_indent(RESPONSE_INDENT + 4, ' ');
+    out << "{\n" << key_indent << "\"map\": \"";
+    {
+        json::EscapedStringWriter map_writer(out);
+        PrintMap(handler, map_writer);
+    }
+    out << "\",\n" << key_indent << "\"request_id\": " << request_id
+        << "\n" << std::string(RESPONSE_INDENT, ' ') << "}";
 }
\ No newline at end of file
@@ -1,23 +1,62 @@
 #pragma once
 
+#include "deflate.h"
 #include "json.h"
+#include "json_builder.h"
 #include "map_renderer.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
+#include "response_cache.h"
+#include <fstream>
+#include <optional>
 #include <unordered_map>
 
 struct StopInfo{
     std::string stop_name;
     geo::Coordinates cords;
-    std::unordered_map<std::string, int> stops_distances;
+    std::vector<std::pair<std::string_view, int>> stops_distances;
 };
 
 struct BusInfo{
     std::string bus_name;
-    std::vector<std::string_view> stops;
+    std::vector<std::string> stops;
     bool is_round;
+    std::vector<double> departures;
 };
 
+struct DistanceInfo{
+    const tc::Stop* from;
+    std::string_view to;
+    int distance;
+};
+
+enum class OutputCompression { NONE, GZIP };
+
+struct OutputSettings{
+    // Сжатие выходных файлов output.json и map.svg, при gzip к их именам добавляется ".gz"
+    OutputCompression compression = OutputCompression::NONE;
+    // Карта из ответа на запрос Map пишется в отдельный файл, а в ответе остаётся его имя
+    bool map_files = false;
+};
+
+// Открывает файл name и передаёт print поток для записи в него, сжимая записанное,
+// если задано сжатие. Возвращает имя записанного файла
+template <typename Print>
+std::string WriteOutputFile(std::string name, OutputCompression compression, Print&& print){
+    if(compression == OutputCompression::GZIP){
+        name += ".gz";
+    }
+    std::ofstream file(name, std::ios::binary);
+    if(compression == OutputCompression::GZIP){
+        deflate::GzipWriter gzip(file);
+        print(gzip);
+    }
+    else{
+        print(file);
+    }
+    return name;
+}
+
 class JsonReader{
 public:
     JsonReader(std::istream& input) : document_(json::Load(input)) {};
@@ -26,25 +65,58 @@ public:
     json::Node GetStatRequests();
     json::Node GetRenderSettings();
     json::Node GetRoutingSettings();
+    json::Node GetOutputSettings();
 
+    // Заполняет справочник за один проход по base_requests, разбирая запросы в нескольких потоках.
+    // Имена копируются в справочник, документ не меняется
     void FillCatalogue(tc::TransportCatalogue& catalogue);
-    void FillStops(json::Array request_values, tc::TransportCatalogue& catalogue);
-    void SetDistancesToStops(json::Array request_values, tc::TransportCatalogue& catalogue);
-    void FillBuses(json::Array request_values, tc::TransportCatalogue& catalogue);
+    void SetDistancesToStops(const std::vector<DistanceInfo>& distances, tc::TransportCatalogue& catalogue);
+    void FillBuses(std::vector<BusInfo>& buses, tc::TransportCatalogue& catalogue);
     StopInfo GetStopInfo(const json::Dict& request) const;
     BusInfo GetBusInfo(const json::Dict& request) const;
 
-    void ApplyRequests(const json::Node& stat_request, const RequestHandler& handler);
-    json::Node GetBusRequest(const json::Dict& stat_request, const RequestHandler& handler) const;
-    json::Node GetStopRequest(const json::Dict& stat_request, const RequestHandler& handler) const;
-    json::Node GetMapRequest(const json::Dict& stat_request, const RequestHandler& handler) const;
-    json::Node GetRouteRequest(const json::Dict& stat_request, const RequestHandler& handler) const;
+    // Отвечает на пакет запросов и пишет ответы в output.json. Ответы на запросы Stop, Bus
+    // и Route без дополнительных параметров сохраняются в кэше и переживают вызов
+    void ApplyRequests(const json::Node& stat_request, const RequestHandler& handler,
+                       const OutputSettings& output_settings = {});
+    ResponseCacheStats GetResponseCacheStats() const;
+    // Ответы строятся в resource: ApplyRequests размещает все ответы пакета в одной арене
+    json::Node GetBusRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                             std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetStopRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetRouteRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                               std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetIsochroneRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                   std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetMatrixRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetParetoRouteRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                     std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetAlternativeRoutesRequest(const json::Dict& stat_request, const RequestHandler& handler,
+                                           std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    json::Node GetRouteResponse(int request_id, const std::optional<std::vector<tc::RouterEdge>>& route,
+                                std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+    // Печатает ответ на запрос Map на уровне ответов пакета, выводя карту в out по мере построения
+    void PrintMapResponse(int request_id, const RequestHandler& handler, std::ostream& out) const;
 
     render::RenderSettings SetRenderSettings(const json::Dict& render_settings);
     svg::Color GetColor(const json::Array& color_variant);
 
     tc::RouterSettings GetRouterSettings(const json::Dict& router_settings);
+    OutputSettings SetOutputSettings(const json::Dict& output_settings);
 
 private:
+    // Добавляет в builder массив элементов Wait и Bus для каждой поездки маршрута
+    void AddRouteItems(json::Builder& builder, const std::vector<tc::RouterEdge>& route) const;
+    // Печатает ответ, сохраняет его в кэше под ключом key и возвращает сохранённую копию
+    ResponseCache::ResponsePtr StoreResponse(std::string key, const json::Node& response);
+    // Пишет карту в отдельный файл и возвращает его имя
+    std::string WriteMapFile(int request_id, const RequestHandler& handler, const OutputSettings& output_settings) const;
+
+    // Ограничение памяти под кэш ответов
+    static constexpr size_t RESPONSE_CACHE_BYTES = 64 * 1024 * 1024;
+
     json::Document document_;
+    ResponseCache response_cache_{RESPONSE_CACHE_BYTES};
 };
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "dijkstra.h"
+#include "graph.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Число попаданий и промахов кэша деревьев кратчайших путей
+struct RouteTreeCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+// Маршрутизатор без таблицы всех пар: дерево кратчайших путей из вершины строится
+// алгоритмом Дейкстры при первом запросе из неё и хранится в LRU-кэше ограниченного размера.
+// Интерфейс совпадает с Router, методы можно вызывать из нескольких потоков одновременно
+template <typename Weight>
+class LazyRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    LazyRouter(const Graph& graph, size_t memory_limit_bytes);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    struct RouteSummary {
+        Weight weight;
+        size_t edge_count = 0;
+    };
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+    std::optional<RouteSummary> GetRouteSummary(VertexId from, VertexId to) const;
+    // Сводки маршрутов из одной вершины во все вершины targets, в том же порядке
+    std::vector<std::optional<RouteSummary>> GetRouteSummaries(VertexId from, const std::vector<VertexId>& targets) const;
+
+    // Сколько деревьев помещается в кэш при заданном ограничении памяти, не меньше одного
+    size_t GetCapacity() const;
+    RouteTreeCacheStats GetStats() const;
+
+private:
+    // Те же особые значения, что и в строках таблицы Router
+    static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+    static constexpr uint32_t ROUTE_START = UINT32_MAX - 1;
+
+    struct RouteTree {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+    using RouteTreePtr = std::shared_ptr<const RouteTree>;
+    // Список источников от недавно использованных к давно использованным
+    using LruList = std::list<std::pair<VertexId, RouteTreePtr>>;
+
+    // Дерево остаётся живым, пока на него ссылается вызывающий, даже если его уже вытеснили из кэша
+    RouteTreePtr GetTree(VertexId from) const;
+    RouteTreePtr BuildTree(VertexId from) const;
+    std::optional<RouteInfo> BuildRouteFromTree(const RouteTree& tree, VertexId to) const;
+    std::optional<RouteSummary> GetRouteSummaryFromTree(const RouteTree& tree, VertexId to) const;
+
+    const Graph& graph_;
+    size_t vertex_count_ = 0;
+    size_t capacity_ = 1;
+
+    mutable std::mutex mutex_;
+    mutable LruList lru_;
+    mutable std::unordered_map<VertexId, typename LruList::iterator> trees_;
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+    mutable std::atomic<uint64_t> evictions_{0};
+};
+
+template <typename Weight>
+LazyRouter<Weight>::LazyRouter(const Graph& graph, size_t memory_limit_bytes)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+{
+    if (graph.GetEdgeCount() >= ROUTE_START) {
+        throw std::length_error("Too many edges for the route tree");
+    }
+    const size_t tree_bytes = std::max<size_t>(1, vertex_count_ * (sizeof(Weight) + sizeof(uint32_t)));
+    capacity_ = std::max<size_t>(1, memory_limit_bytes / tree_bytes);
+    trees_.reserve(std::min(capacity_, vertex_count_) + 1);
+}
+
+template <typename Weight>
+size_t LazyRouter<Weight>::GetCapacity() const {
+    return capacity_;
+}
+
+template <typename Weight>
+RouteTreeCacheStats LazyRouter<Weight>::GetStats() const {
+    return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed),
+            evictions_.load(std::memory_order_relaxed)};
+}
+
+template <typename Weight>
+typename LazyRouter<Weight>::RouteTreePtr LazyRouter<Weight>::GetTree(VertexId from) const {
+    if (from >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    {
+        std::lock_guard lock(mutex_);
+        if (const auto it = trees_.find(from); it != trees_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            TC_METRICS_COUNT("route_tree_cache_hits", 1);
+            return it->second->second;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    TC_METRICS_COUNT("route_tree_cache_misses", 1);
+    // Дерево строится без блокировки, чтобы промахи в разных потоках не ждали друг друга.
+    // Если то же дерево успел построить другой поток, остаётся его копия
+    RouteTreePtr tree = BuildTree(from);
+
+    std::lock_guard lock(mutex_);
+    if (const auto it = trees_.find(from); it != trees_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+    lru_.emplace_front(from, tree);
+    trees_.emplace(from, lru_.begin());
+    while (lru_.size() > capacity_) {
+        trees_.erase(lru_.back().first);
+        lru_.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return tree;
+}
+
+template <typename Weight>
+typename LazyRouter<Weight>::RouteTreePtr LazyRouter<Weight>::BuildTree(VertexId from) const {
+    ShortestPathSearch<Weight> search(graph_);
+    search.Run(from);
+    auto tree = std::make_shared<RouteTree>();
+    tree->weights.resize(vertex_count_);
+    tree->prev_edges.assign(vertex_count_, NO_ROUTE);
+    for (const VertexId vertex : search.GetSettledVertices()) {
+        tree->weights[vertex] = search.GetWeight(vertex);
+        const std::optional<EdgeId> prev_edge = search.GetPrevEdge(vertex);
+        tree->prev_edges[vertex] = prev_edge ? static_cast<uint32_t>(*prev_edge) : ROUTE_START;
+    }
+    return tree;
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteInfo> LazyRouter<Weight>::BuildRoute(VertexId from,
+                                                                                     VertexId to) const {
+    return BuildRouteFromTree(*GetTree(from), to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename LazyRouter<Weight>::RouteInfo>>
+LazyRouter<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const {
+    const RouteTreePtr tree = GetTree(from);
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        routes.push_back(BuildRouteFromTree(*tree, to));
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteSummary> LazyRouter<Weight>::GetRouteSummary(VertexId from,
+                                                                                           VertexId to) const {
+    return GetRouteSummaryFromTree(*GetTree(from), to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename LazyRouter<Weight>::RouteSummary>>
+LazyRouter<Weight>::GetRouteSummaries(VertexId from, const std::vector<VertexId>& targets) const {
+    const RouteTreePtr tree = GetTree(from);
+    std::vector<std::optional<RouteSummary>> summaries;
+    summaries.reserve(targets.size());
+    for (const VertexId to : targets) {
+        summaries.push_back(GetRouteSummaryFromTree(*tree, to));
+    }
+    return summaries;
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteSummary>
+LazyRouter<Weight>::GetRouteSummaryFromTree(const RouteTree& tree, VertexId to) const {
+    if (to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (tree.prev_edges[to] == NO_ROUTE) {
+        return std::nullopt;
+    }
+    size_t edge_count = 0;
+    for (uint32_t edge_id = tree.prev_edges[to]; edge_id != ROUTE_START;
+         edge_id = tree.prev_edges[graph_.GetEdge(edge_id).from]) {
+        ++edge_count;
+    }
+    return RouteSummary{tree.weights[to], edge_count};
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteInfo>
+LazyRouter<Weight>::BuildRouteFromTree(const RouteTree& tree, VertexId to) const {
+    if (to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (tree.prev_edges[to] == NO_ROUTE) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (uint32_t edge_id = tree.prev_edges[to]; edge_id != ROUTE_START;
+         edge_id = tree.prev_edges[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{tree.weights[to], std::move(edges)};
+}
+
+}  // namespace graph
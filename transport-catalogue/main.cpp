@@ -1,7 +1,13 @@
+#include "binary_protocol.h"
 #include "json_reader.h"
 #include "request_handler.h"
+#include "metrics.h"
 
-int main() {
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+int main(int argc, char* argv[]) {
     tc::TransportCatalogue catalogue;
     std::ifstream input("input.json");
     JsonReader json_reader(input);
@@ -13,8 +19,61 @@ int main() {
     
     tc::TransportRouter router(json_reader.GetRouterSettings(routing_settings), catalogue);
 
+    const json::Node output_settings_node = json_reader.GetOutputSettings();
+    const OutputSettings output_settings = output_settings_node.IsNull() ? OutputSettings{}
+                                                                         : json_reader.SetOutputSettings(output_settings_node.AsDict());
+
     RequestHandler rh(catalogue, renderer, router);
-    json_reader.ApplyRequests(stat_requests, rh);
-    std::ofstream file("map.svg");
-    rh.RenderMap().Render(file);
+    const std::string_view mode = argc > 1 ? argv[1] : "";
+    int exit_code = 0;
+    // С ключом --binary программа работает сервером двоичного протокола: отвечает на кадры
+    // из стандартного ввода в стандартный вывод, пока ввод не закончится.
+    // С ключом --binary-batch <in> <out> отвечает на кадры из файла in и пишет ответы в файл out.
+    // Повреждённый кадр завершает работу с сообщением об ошибке и ненулевым кодом возврата
+    if(mode == "--binary" || mode == "--binary-batch"){
+        try{
+            if(mode == "--binary"){
+                std::ios::sync_with_stdio(false);
+                binary::Server(rh).Serve(std::cin, std::cout, true);
+            }
+            else if(argc != 4){
+                std::cerr << "Usage: " << argv[0] << " --binary-batch <requests> <responses>" << std::endl;
+                exit_code = 1;
+            }
+            else if(std::ifstream binary_requests(argv[2], std::ios::binary); !binary_requests){
+                std::cerr << "Cannot open " << argv[2] << std::endl;
+                exit_code = 1;
+            }
+            else{
+                std::ofstream binary_responses(argv[3], std::ios::binary);
+                binary::Server(rh).Serve(binary_requests, binary_responses, false);
+            }
+        }
+        catch(const std::invalid_argument& e){
+            std::cout.flush();
+            std::cerr << "Malformed binary request: " << e.what() << std::endl;
+            exit_code = 1;
+        }
+    }
+    else{
+        json_reader.ApplyRequests(stat_requests, rh, output_settings);
+        if(rh.GetMapFormat() == render::MapFormat::PNG){
+            std::ofstream file("map.png", std::ios::binary);
+            rh.RenderMapPng(file);
+        }
+        else{
+            WriteOutputFile("map.svg", output_settings.compression, [&rh](std::ostream& out){
+                rh.RenderMap(out);
+            });
+        }
+    }
+
+#ifdef TC_METRICS
+    // Отчёт о замерах пишется при завершении в двух форматах: JSON и текстовом формате Prometheus
+    std::ofstream metrics_json("metrics.json");
+    metrics::Registry::Instance().PrintJson(metrics_json);
+    std::ofstream metrics_prometheus("metrics.prom");
+    metrics::Registry::Instance().PrintPrometheus(metrics_prometheus);
+#endif
+    return exit_code;
 }
\ No newline at end of file
@@ -1,4 +1,12 @@
 #include "map_renderer.h"
+#include "flat_hash_map.h"
+#include "parallel.h"
+#include "png.h"
+#include "raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 namespace render{
 
@@ -17,57 +25,292 @@ SphereProjector SphereProjector::GetSphereProjector(const std::vector<geo::Coord
 std::vector<geo::Coordinates> MapRenderer::GetCoordinatesVector(const tc::TransportCatalogue& catalogue) const{
     std::vector<geo::Coordinates> cords;
     for(const auto& [bus_name, bus] : catalogue.GetBusesMap()){
-        for(const auto& bus_stop : bus->stop_names){
-            cords.push_back({catalogue.FindStopByName(bus_stop)->cords});
+        for(const uint32_t stop_id : catalogue.GetBusStopIds(*bus)){
+            cords.push_back(catalogue.GetStopById(stop_id)->cords);
         }
     }
     return cords;
 }
 
-std::vector<svg::Polyline> MapRenderer::GetRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
-    std::vector<svg::Polyline> lines;
-    render::RenderSettings render_settings = GetRenderSettings();
-    size_t color_index = 0;
-    for(const auto& bus : catalogue.GetAllSortedBuses()){
-        if(bus.stop_names.empty()){
-            continue;
+namespace {
+// Приближённые размеры надписи шрифтом Verdana в долях размера шрифта:
+// средняя ширина символа, высота над базовой линией и под ней
+constexpr double LABEL_CHAR_WIDTH = 0.6;
+constexpr double LABEL_ASCENT = 0.8;
+constexpr double LABEL_DESCENT = 0.2;
+
+struct LabelBox {
+    double left;
+    double top;
+    double right;
+    double bottom;
+};
+
+size_t CountUtf8Chars(std::string_view text){
+    return std::count_if(text.begin(), text.end(), [](char c){
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    });
+}
+
+// Прямоугольник надписи вместе с подложкой шириной underlayer_width
+LabelBox GetLabelBox(svg::Point position, const std::vector<double>& offset, int font_size,
+                     std::string_view text, double underlayer_width){
+    const double x = position.x + offset[0];
+    const double baseline = position.y + offset[1];
+    const double margin = underlayer_width / 2;
+    return {x - margin, baseline - font_size * LABEL_ASCENT - margin,
+            x + CountUtf8Chars(text) * font_size * LABEL_CHAR_WIDTH + margin, baseline + font_size * LABEL_DESCENT + margin};
+}
+
+// Размещённые надписи, разложенные по ячейкам равномерной сетки. Надпись хранится
+// во всех ячейках, которые она задевает, поэтому проверка смотрит только соседей
+class LabelGrid {
+public:
+    LabelGrid(double width, double height, double cell_size)
+        : cell_size_(cell_size)
+        , columns_(static_cast<int>(std::ceil(width / cell_size)) + 1)
+        , rows_(static_cast<int>(std::ceil(height / cell_size)) + 1)
+        , cells_(static_cast<size_t>(columns_) * rows_) {
+    }
+
+    // Размещает надпись, если она не пересекается с уже размещёнными
+    bool TryPlace(const LabelBox& box){
+        const int column_begin = GetCell(box.left, columns_);
+        const int column_end = GetCell(box.right, columns_) + 1;
+        const int row_begin = GetCell(box.top, rows_);
+        const int row_end = GetCell(box.bottom, rows_) + 1;
+        for(int row = row_begin; row < row_end; ++row){
+            for(int column = column_begin; column < column_end; ++column){
+                for(const LabelBox& placed : cells_[row * columns_ + column]){
+                    if(box.left < placed.right && placed.left < box.right && box.top < placed.bottom && placed.top < box.bottom){
+                        return false;
+                    }
+                }
+            }
         }
-        svg::Polyline line;
-        std::vector<std::string> stop_names{bus.stop_names.begin(),bus.stop_names.end()};
-        if(!bus.is_roundtrip){
-            stop_names.insert(stop_names.end(), std::next(bus.stop_names.rbegin()), bus.stop_names.rend());
+        for(int row = row_begin; row < row_end; ++row){
+            for(int column = column_begin; column < column_end; ++column){
+                cells_[row * columns_ + column].push_back(box);
+            }
         }
-        for(const auto& stop : stop_names){
-            line.AddPoint(projector(catalogue.FindStopByName(stop)->cords));
+        return true;
+    }
+
+private:
+    // Надписи за краем карты попадают в крайние ячейки
+    int GetCell(double coordinate, int count) const {
+        return std::clamp(static_cast<int>(std::floor(coordinate / cell_size_)), 0, count - 1);
+    }
+
+    double cell_size_;
+    int columns_;
+    int rows_;
+    std::vector<std::vector<LabelBox>> cells_;
+};
+
+// Упрощение ломаной алгоритмом Дугласа-Пекера: остаются точки, без которых
+// ломаная отклонилась бы больше чем на tolerance. Концы ломаной сохраняются
+std::vector<svg::Point> SimplifyPolyline(const std::vector<svg::Point>& points, double tolerance){
+    if(points.size() <= 2){
+        return points;
+    }
+    std::vector<bool> keep(points.size());
+    keep.front() = keep.back() = true;
+    std::vector<std::pair<size_t, size_t>> ranges = {{0, points.size() - 1}};
+    while(!ranges.empty()){
+        const auto [first, last] = ranges.back();
+        ranges.pop_back();
+        const svg::Point& a = points[first];
+        const double dx = points[last].x - a.x;
+        const double dy = points[last].y - a.y;
+        const double length = std::sqrt(dx * dx + dy * dy);
+        double max_distance = 0;
+        size_t farthest = first;
+        for(size_t i = first + 1; i < last; ++i){
+            // У замкнутого участка концы совпадают, и отклонение считается от точки
+            const double distance = length > 0 ? std::abs(dx * (points[i].y - a.y) - dy * (points[i].x - a.x)) / length
+                                               : std::hypot(points[i].x - a.x, points[i].y - a.y);
+            if(distance > max_distance){
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+        if(max_distance > tolerance){
+            keep[farthest] = true;
+            ranges.push_back({first, farthest});
+            ranges.push_back({farthest, last});
         }
-        line.SetStrokeColor(render_settings.color_palette[color_index % render_settings.color_palette.size()]);
-        ++color_index;
-        line.SetFillColor("none");
-        line.SetStrokeWidth(render_settings.line_width);
-        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-        lines.push_back(line);
     }
-    return lines;
+    std::vector<svg::Point> result;
+    for(size_t i = 0; i < points.size(); ++i){
+        if(keep[i]){
+            result.push_back(points[i]);
+        }
+    }
+    return result;
+}
 }
 
-std::vector<svg::Text> MapRenderer::GetBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
-    std::vector<svg::Text> bus_text;
-    render::RenderSettings render_settings = GetRenderSettings();
-    size_t color_index = 0;
-    for (const auto& bus : catalogue.GetAllSortedBuses()){
-        if(bus.stop_names.empty()){
+MapRenderer::MapItems MapRenderer::GetMapItems(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
+    MapItems items;
+    for(const auto& [bus_name, bus] : catalogue.GetBusesMap()){
+        if(bus->stop_count != 0){
+            items.buses.push_back(bus);
+        }
+    }
+    std::sort(items.buses.begin(), items.buses.end(), [](const tc::Bus* left_bus, const tc::Bus* right_bus){
+        // Тот же порядок, что и у TransportCatalogue::GetAllSortedBuses
+        return std::lexicographical_compare(left_bus->bus_name.begin(), left_bus->bus_name.end(),
+                                            right_bus->bus_name.begin(), right_bus->bus_name.end());
+    });
+    for(uint32_t id = 0; id < catalogue.GetStopCount(); ++id){
+        const tc::Stop* stop = catalogue.GetStopById(id);
+        if(!catalogue.GetStopInfo(stop->stop_name).empty()){
+            items.stops.push_back(stop);
+        }
+    }
+    std::sort(items.stops.begin(), items.stops.end(), [](const tc::Stop* left_stop, const tc::Stop* right_stop){
+        return std::lexicographical_compare(left_stop->stop_name.begin(), left_stop->stop_name.end(),
+                                            right_stop->stop_name.begin(), right_stop->stop_name.end());
+    });
+    if(GetRenderSettings().lod_tolerance > 0){
+        PlanLevelOfDetail(projector, catalogue, items);
+    }
+    return items;
+}
+
+void MapRenderer::PlanLevelOfDetail(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, MapItems& items) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    items.lod = true;
+
+    // Линия некольцевого маршрута на обратном пути проходит те же отрезки, поэтому
+    // рисуется только прямой путь. Отрезок между парой остановок, общий для нескольких
+    // маршрутов, рисуется только у последнего из них: его линия всё равно легла бы сверху
+    items.segment_begin.reserve(items.buses.size());
+    size_t segment_count = 0;
+    for(const tc::Bus* bus : items.buses){
+        items.segment_begin.push_back(segment_count);
+        segment_count += bus->stop_count - 1;
+    }
+    auto get_segment_key = [](uint32_t from, uint32_t to){
+        return static_cast<uint64_t>(std::min(from, to)) << 32 | std::max(from, to);
+    };
+    flat::U64HashMap<size_t> last_segments;
+    last_segments.Reserve(segment_count);
+    for(size_t i = 0; i < items.buses.size(); ++i){
+        const auto stop_ids = catalogue.GetBusStopIds(*items.buses[i]);
+        for(size_t j = 1; j < items.buses[i]->stop_count; ++j){
+            last_segments.Set(get_segment_key(stop_ids.begin()[j - 1], stop_ids.begin()[j]), items.segment_begin[i] + j - 1);
+        }
+    }
+    items.visible_segments.resize(segment_count);
+    for(size_t i = 0; i < items.buses.size(); ++i){
+        const auto stop_ids = catalogue.GetBusStopIds(*items.buses[i]);
+        for(size_t j = 1; j < items.buses[i]->stop_count; ++j){
+            const size_t segment = items.segment_begin[i] + j - 1;
+            items.visible_segments[segment] = *last_segments.Find(get_segment_key(stop_ids.begin()[j - 1], stop_ids.begin()[j])) == segment;
+        }
+    }
+
+    // Надписи размещаются в порядке вывода, названия маршрутов раньше названий остановок.
+    // Надпись, которая наложилась бы на уже размещённую, пропускается
+    const double cell_size = std::max({render_settings.bus_label_font_size, render_settings.stop_label_font_size, 1}) * 4.0;
+    LabelGrid grid(render_settings.width, render_settings.height, cell_size);
+    items.visible_bus_labels.resize(items.buses.size() * 2);
+    for(size_t i = 0; i < items.buses.size(); ++i){
+        const tc::Bus& bus = *items.buses[i];
+        const auto stop_ids = catalogue.GetBusStopIds(bus);
+        const uint32_t first_stop = *stop_ids.begin();
+        const uint32_t last_stop = *std::prev(stop_ids.end());
+        auto place = [&](uint32_t stop_id){
+            return grid.TryPlace(GetLabelBox(projector(catalogue.GetStopById(stop_id)->cords), render_settings.bus_label_offset,
+                                             render_settings.bus_label_font_size, bus.bus_name, render_settings.underlayer_width));
+        };
+        items.visible_bus_labels[2 * i] = place(first_stop);
+        if(!bus.is_roundtrip && first_stop != last_stop){
+            items.visible_bus_labels[2 * i + 1] = place(last_stop);
+        }
+    }
+    items.visible_stop_labels.resize(items.stops.size());
+    for(size_t i = 0; i < items.stops.size(); ++i){
+        const tc::Stop& stop = *items.stops[i];
+        items.visible_stop_labels[i] = grid.TryPlace(GetLabelBox(projector(stop.cords), render_settings.stop_label_offset,
+                                                                 render_settings.stop_label_font_size, stop.stop_name,
+                                                                 render_settings.underlayer_width));
+    }
+}
+
+template <typename Emit>
+void MapRenderer::EmitRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue,
+                                 const MapItems& items, size_t begin, size_t end, Emit&& emit) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    for(size_t color_index = begin; color_index < end; ++color_index){
+        const tc::Bus& bus = *items.buses[color_index];
+        auto emit_line = [&](svg::Polyline line){
+            line.SetStrokeColor(render_settings.color_palette[color_index % render_settings.color_palette.size()]);
+            line.SetFillColor("none");
+            line.SetStrokeWidth(render_settings.line_width);
+            line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+            line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+            emit(std::move(line));
+        };
+        const auto stop_ids = catalogue.GetBusStopIds(bus);
+        if(items.lod){
+            // Видимые отрезки подряд образуют отдельную упрощённую ломаную
+            std::vector<svg::Point> piece;
+            auto emit_piece = [&](){
+                if(piece.size() >= 2){
+                    svg::Polyline line;
+                    for(const svg::Point& point : SimplifyPolyline(piece, render_settings.lod_tolerance)){
+                        line.AddPoint(point);
+                    }
+                    emit_line(std::move(line));
+                }
+                piece.clear();
+            };
+            for(size_t j = 1; j < bus.stop_count; ++j){
+                if(!items.visible_segments[items.segment_begin[color_index] + j - 1]){
+                    emit_piece();
+                    continue;
+                }
+                if(piece.empty()){
+                    piece.push_back(projector(catalogue.GetStopById(stop_ids.begin()[j - 1])->cords));
+                }
+                piece.push_back(projector(catalogue.GetStopById(stop_ids.begin()[j])->cords));
+            }
+            emit_piece();
             continue;
         }
+        svg::Polyline line;
+        for(const uint32_t stop_id : stop_ids){
+            line.AddPoint(projector(catalogue.GetStopById(stop_id)->cords));
+        }
+        if(!bus.is_roundtrip){
+            for(auto it = std::next(std::make_reverse_iterator(stop_ids.end())); it != std::make_reverse_iterator(stop_ids.begin()); ++it){
+                line.AddPoint(projector(catalogue.GetStopById(*it)->cords));
+            }
+        }
+        emit_line(std::move(line));
+    }
+}
+
+template <typename Emit>
+void MapRenderer::EmitBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue,
+                               const MapItems& items, size_t begin, size_t end, Emit&& emit) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    for(size_t color_index = begin; color_index < end; ++color_index){
+        const tc::Bus& bus = *items.buses[color_index];
+        const auto stop_ids = catalogue.GetBusStopIds(bus);
+        const uint32_t first_stop = *stop_ids.begin();
+        const uint32_t last_stop = *std::prev(stop_ids.end());
         svg::Text text;
-        text.SetPosition(projector(catalogue.FindStopByName(bus.stop_names[0])->cords));
+        text.SetPosition(projector(catalogue.GetStopById(first_stop)->cords));
         text.SetOffset(svg::Point({render_settings.bus_label_offset[0], render_settings.bus_label_offset[1]}));
         text.SetFontSize(render_settings.bus_label_font_size);
         text.SetFontFamily("Verdana");
         text.SetFontWeight("bold");
         text.SetData(bus.bus_name);
         text.SetFillColor(render_settings.color_palette[color_index % render_settings.color_palette.size()]);
-        ++color_index;
 
         svg::Text underlayer = text;
         underlayer.SetFillColor(render_settings.underlayer_color);
@@ -76,44 +319,52 @@ std::vector<svg::Text> MapRenderer::GetBusNames(const SphereProjector& projector
         underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
         underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-        bus_text.push_back(underlayer);
-        bus_text.push_back(text);
-        if(!bus.is_roundtrip && bus.stop_names[0] != bus.stop_names.back()){
+        const bool has_second_label = !bus.is_roundtrip && first_stop != last_stop;
+        const bool first_visible = !items.lod || items.visible_bus_labels[2 * color_index];
+        const bool second_visible = has_second_label && (!items.lod || items.visible_bus_labels[2 * color_index + 1]);
+        if(second_visible){
+            const auto& bus_cords = catalogue.GetStopById(last_stop)->cords;
             svg::Text second_text = text;
-            const auto& bus_cords = catalogue.FindStopByName(bus.stop_names.back())->cords;
             second_text.SetPosition(projector(bus_cords));
             svg::Text second_underlayer = underlayer;
             second_underlayer.SetPosition(projector(bus_cords));
-            bus_text.push_back(second_underlayer);
-            bus_text.push_back(second_text);
+            if(first_visible){
+                emit(std::move(underlayer));
+                emit(std::move(text));
+            }
+            emit(std::move(second_underlayer));
+            emit(std::move(second_text));
+        }
+        else if(first_visible){
+            emit(std::move(underlayer));
+            emit(std::move(text));
         }
     }
-    return bus_text;
 }
 
-std::vector<svg::Circle> MapRenderer::GetStopCircles(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
-    std::vector<svg::Circle> stop_circles;
-    render::RenderSettings render_settings = GetRenderSettings();
-    for(const auto& stop : catalogue.GetAllSortedStops()){
-        if(catalogue.GetStopInfo(stop.stop_name).empty()){
-            continue;
-        }
+template <typename Emit>
+void MapRenderer::EmitStopCircles(const SphereProjector& projector, const MapItems& items,
+                                  size_t begin, size_t end, Emit&& emit) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    for(size_t i = begin; i < end; ++i){
+        const tc::Stop& stop = *items.stops[i];
         svg::Circle circle;
         circle.SetCenter(projector(stop.cords));
         circle.SetRadius(render_settings.stop_radius);
         circle.SetFillColor("white");
-        stop_circles.push_back(circle);
+        emit(std::move(circle));
     }
-    return stop_circles;
 }
 
-std::vector<svg::Text> MapRenderer::GetStopNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
-    std::vector<svg::Text> stop_names;
-    render::RenderSettings render_settings = GetRenderSettings();
-    for(const auto& stop : catalogue.GetAllSortedStops()){
-        if(catalogue.GetStopInfo(stop.stop_name).empty()){
+template <typename Emit>
+void MapRenderer::EmitStopNames(const SphereProjector& projector, const MapItems& items,
+                                size_t begin, size_t end, Emit&& emit) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    for(size_t i = begin; i < end; ++i){
+        if(items.lod && !items.visible_stop_labels[i]){
             continue;
         }
+        const tc::Stop& stop = *items.stops[i];
         svg::Text text;
         text.SetPosition(projector(stop.cords));
         text.SetOffset(svg::Point({render_settings.stop_label_offset[0], render_settings.stop_label_offset[1]}));
@@ -129,34 +380,90 @@ std::vector<svg::Text> MapRenderer::GetStopNames(const SphereProjector& projecto
         underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
         underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-        stop_names.push_back(underlayer);
-        stop_names.push_back(text);
+        emit(std::move(underlayer));
+        emit(std::move(text));
     }
+}
+
+std::vector<svg::Polyline> MapRenderer::GetRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
+    std::vector<svg::Polyline> lines;
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitRouteLines(projector, catalogue, items, 0, items.buses.size(), [&lines](svg::Polyline line){
+        lines.push_back(std::move(line));
+    });
+    return lines;
+}
+
+std::vector<svg::Text> MapRenderer::GetBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
+    std::vector<svg::Text> bus_text;
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitBusNames(projector, catalogue, items, 0, items.buses.size(), [&bus_text](svg::Text text){
+        bus_text.push_back(std::move(text));
+    });
+    return bus_text;
+}
+
+std::vector<svg::Circle> MapRenderer::GetStopCircles(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
+    std::vector<svg::Circle> stop_circles;
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitStopCircles(projector, items, 0, items.stops.size(), [&stop_circles](svg::Circle circle){
+        stop_circles.push_back(std::move(circle));
+    });
+    return stop_circles;
+}
+
+std::vector<svg::Text> MapRenderer::GetStopNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const{
+    std::vector<svg::Text> stop_names;
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitStopNames(projector, items, 0, items.stops.size(), [&stop_names](svg::Text text){
+        stop_names.push_back(std::move(text));
+    });
     return stop_names;
 }
 
-void MapRenderer::RenderRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const {
-    for(const auto& line : GetRouteLines(projector, catalogue)){
-        render_doc.Add(line);
-    }
+void MapRenderer::RenderRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const {
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitRouteLines(projector, catalogue, items, 0, items.buses.size(), [&render_doc](svg::Polyline line){
+        render_doc.Add(std::move(line));
+    });
 }
 
-void MapRenderer::RenderBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const{
-    for(const auto& text : GetBusNames(projector, catalogue)){
-        render_doc.Add(text);
-    }
+void MapRenderer::RenderBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const{
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitBusNames(projector, catalogue, items, 0, items.buses.size(), [&render_doc](svg::Text text){
+        render_doc.Add(std::move(text));
+    });
 }
 
-void MapRenderer::RenderStopCircles(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const{
-    for(const auto& circle : GetStopCircles(projector, catalogue)){
-        render_doc.Add(circle);
-    }
+void MapRenderer::RenderStopCircles(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const{
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitStopCircles(projector, items, 0, items.stops.size(), [&render_doc](svg::Circle circle){
+        render_doc.Add(std::move(circle));
+    });
 }
 
-void MapRenderer::RenderStopNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const{
-    for(const auto& stop_name : GetStopNames(projector, catalogue)){
-        render_doc.Add(stop_name);
+void MapRenderer::RenderStopNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const{
+    const MapItems items = GetMapItems(projector, catalogue);
+    EmitStopNames(projector, items, 0, items.stops.size(), [&render_doc](svg::Text text){
+        render_doc.Add(std::move(text));
+    });
+}
+
+svg::Document MapRenderer::RenderStopsOverlay(const tc::TransportCatalogue& catalogue, const std::vector<std::string_view>& stop_names) const{
+    svg::Document render_doc;
+    const RenderSettings& render_settings = GetRenderSettings();
+    SphereProjector projector = projector.GetSphereProjector(GetCoordinatesVector(catalogue), render_settings);
+    const svg::Color& color = render_settings.color_palette.empty() ? svg::NoneColor : render_settings.color_palette.front();
+    for(const auto& stop_name : stop_names){
+        svg::Circle circle;
+        circle.SetCenter(projector(catalogue.FindStopByName(stop_name)->cords));
+        circle.SetRadius(render_settings.stop_radius * 2);
+        circle.SetFillColor(color);
+        circle.SetStrokeColor(render_settings.underlayer_color);
+        circle.SetStrokeWidth(render_settings.underlayer_width);
+        render_doc.Add(circle);
     }
+    return render_doc;
 }
 
 svg::Document MapRenderer::RenderMap(const tc::TransportCatalogue& catalogue) const{
@@ -168,4 +475,95 @@ svg::Document MapRenderer::RenderMap(const tc::TransportCatalogue& catalogue) co
     RenderStopNames(projector, catalogue, render_doc);
     return render_doc;
 }
+
+void MapRenderer::RenderMap(const tc::TransportCatalogue& catalogue, std::ostream& out) const{
+    SphereProjector projector = projector.GetSphereProjector(GetCoordinatesVector(catalogue), GetRenderSettings());
+    const MapItems items = GetMapItems(projector, catalogue);
+
+    // Каждый слой делится на куски по MAP_CHUNK_SIZE маршрутов или остановок.
+    // Куски всех слоёв строятся параллельно в собственные буферы и выводятся
+    // в порядке слоёв, поэтому результат не зависит от числа потоков
+    enum class Layer { ROUTE_LINES, BUS_NAMES, STOP_CIRCLES, STOP_NAMES };
+    struct LayerChunk {
+        Layer layer;
+        size_t begin;
+        size_t end;
+    };
+    constexpr size_t MAP_CHUNK_SIZE = 256;
+    std::vector<LayerChunk> chunks;
+    auto add_layer = [&chunks](Layer layer, size_t count){
+        for(size_t begin = 0; begin < count; begin += MAP_CHUNK_SIZE){
+            chunks.push_back({layer, begin, std::min(count, begin + MAP_CHUNK_SIZE)});
+        }
+    };
+    add_layer(Layer::ROUTE_LINES, items.buses.size());
+    add_layer(Layer::BUS_NAMES, items.buses.size());
+    add_layer(Layer::STOP_CIRCLES, items.stops.size());
+    add_layer(Layer::STOP_NAMES, items.stops.size());
+
+    auto render_chunk = [&](const LayerChunk& chunk, std::ostream& chunk_out){
+        // Отступы те же, что у объектов, выводимых svg::StreamDocument
+        auto emit = [&chunk_out](const auto& object){
+            object.Render(svg::RenderContext{chunk_out, 2, 2});
+        };
+        switch(chunk.layer){
+        case Layer::ROUTE_LINES:
+            EmitRouteLines(projector, catalogue, items, chunk.begin, chunk.end, emit);
+            break;
+        case Layer::BUS_NAMES:
+            EmitBusNames(projector, catalogue, items, chunk.begin, chunk.end, emit);
+            break;
+        case Layer::STOP_CIRCLES:
+            EmitStopCircles(projector, items, chunk.begin, chunk.end, emit);
+            break;
+        case Layer::STOP_NAMES:
+            EmitStopNames(projector, items, chunk.begin, chunk.end, emit);
+            break;
+        }
+    };
+
+    svg::StreamDocument render_doc(out);
+    // Куски обрабатываются волнами: в памяти одновременно лежат буферы только одной волны,
+    // а не вся карта. На поток приходится несколько кусков, чтобы потоки создавались реже
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+    const size_t wave_size = par::GetChunkCount(chunks.size(), 1) * CHUNKS_PER_THREAD;
+    std::vector<std::string> buffers(std::min(wave_size, chunks.size()));
+    for(size_t wave_begin = 0; wave_begin < chunks.size(); wave_begin += wave_size){
+        const size_t wave_end = std::min(chunks.size(), wave_begin + wave_size);
+        par::ForEachChunk(wave_end - wave_begin, CHUNKS_PER_THREAD, [&](size_t, size_t begin, size_t end){
+            for(size_t i = begin; i < end; ++i){
+                std::ostringstream chunk_out;
+                render_chunk(chunks[wave_begin + i], chunk_out);
+                buffers[i] = chunk_out.str();
+            }
+        });
+        for(size_t i = 0; i < wave_end - wave_begin; ++i){
+            out.write(buffers[i].data(), buffers[i].size());
+        }
+    }
+    render_doc.Close();
+}
+
+void MapRenderer::RenderMapPng(const tc::TransportCatalogue& catalogue, std::ostream& out) const{
+    const RenderSettings& render_settings = GetRenderSettings();
+    SphereProjector projector = projector.GetSphereProjector(GetCoordinatesVector(catalogue), render_settings);
+    const MapItems items = GetMapItems(projector, catalogue);
+
+    raster::Canvas canvas(static_cast<uint32_t>(std::ceil(render_settings.width)),
+                          static_cast<uint32_t>(std::ceil(render_settings.height)));
+    // Каждый поток рисует все слои, но только в своей полосе строк, поэтому
+    // порядок наложения объектов в каждом пикселе тот же, что и при рисовании целиком
+    constexpr size_t MIN_BAND_ROWS = 32;
+    par::ForEachChunk(canvas.GetHeight(), MIN_BAND_ROWS, [&](size_t, size_t begin, size_t end){
+        raster::Painter painter(canvas, static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+        auto draw = [&painter](const auto& object){
+            painter.Draw(object);
+        };
+        EmitRouteLines(projector, catalogue, items, 0, items.buses.size(), draw);
+        EmitBusNames(projector, catalogue, items, 0, items.buses.size(), draw);
+        EmitStopCircles(projector, items, 0, items.stops.size(), draw);
+        EmitStopNames(projector, items, 0, items.stops.size(), draw);
+    });
+    png::Write(out, canvas.GetWidth(), canvas.GetHeight(), canvas.GetPixels());
+}
 }
\ No newline at end of file
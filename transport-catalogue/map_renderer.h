@@ -78,6 +78,12 @@ private:
     double zoom_coeff_ = 0;
 };
 
+// Формат карты: SVG или растровое изображение PNG
+enum class MapFormat {
+    SVG,
+    PNG
+};
+
 struct RenderSettings{
     double width;
     double height;
@@ -91,6 +97,11 @@ struct RenderSettings{
     svg::Color underlayer_color;
     double underlayer_width;
     std::vector<svg::Color> color_palette;
+    MapFormat format = MapFormat::SVG;
+    // Допуск упрощения линий маршрутов в пикселях. Если он больше нуля, карта рисуется
+    // в обзорном виде: линии упрощаются, общие отрезки маршрутов рисуются один раз,
+    // а надписи, которые наложились бы на уже выведенные, пропускаются
+    double lod_tolerance = 0;
 };
 
 class MapRenderer{
@@ -102,12 +113,56 @@ public:
     std::vector<svg::Circle> GetStopCircles(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue) const;
     std::vector<svg::Text> GetStopNames(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue) const;
     svg::Document RenderMap(const tc::TransportCatalogue& catalogue) const;
-    void RenderRouteLines(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const;
-    void RenderBusNames(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const;
-    void RenderStopCircles(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const;
-    void RenderStopNames(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::Document& render_doc) const;
+    // Выводит карту в out по мере построения, не собирая svg::Document.
+    // Результат совпадает с RenderMap(catalogue).Render(out). Части слоёв строятся параллельно
+    void RenderMap(const tc::TransportCatalogue& catalogue, std::ostream& out) const;
+    // Рисует ту же карту встроенным растеризатором и выводит в out изображение PNG
+    // размером width x height. Полосы изображения рисуются параллельно
+    void RenderMapPng(const tc::TransportCatalogue& catalogue, std::ostream& out) const;
+    // Слой, выделяющий остановки stop_names. Проекция та же, что и у карты,
+    // поэтому слой накладывается поверх результата RenderMap
+    svg::Document RenderStopsOverlay(const tc::TransportCatalogue& catalogue, const std::vector<std::string_view>& stop_names) const;
+    void RenderRouteLines(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const;
+    void RenderBusNames(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const;
+    void RenderStopCircles(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const;
+    void RenderStopNames(const render::SphereProjector& projector, const tc::TransportCatalogue& catalogue, svg::ObjectContainer& render_doc) const;
     std::vector<geo::Coordinates> GetCoordinatesVector(const tc::TransportCatalogue& catalogue) const;
 private:
+    // Элементы слоёв карты. Строятся один раз на карту, а при выводе слоёв только читаются,
+    // в том числе из нескольких потоков
+    struct MapItems {
+        // Маршруты с остановками по алфавиту. Номер маршрута в списке задаёт его цвет в палитре
+        std::vector<const tc::Bus*> buses;
+        // Остановки, через которые проходят маршруты, по алфавиту
+        std::vector<const tc::Stop*> stops;
+        // Поля ниже заполняются только для обзорной карты, см. RenderSettings::lod_tolerance
+        bool lod = false;
+        // Видны ли отрезки линий. Отрезки маршрута buses[i] начинаются с segment_begin[i]
+        std::vector<size_t> segment_begin;
+        std::vector<bool> visible_segments;
+        // У маршрута buses[i] надпись 2 * i у первой остановки и 2 * i + 1 у конечной
+        std::vector<bool> visible_bus_labels;
+        std::vector<bool> visible_stop_labels;
+    };
+
+    MapItems GetMapItems(const SphereProjector& projector, const tc::TransportCatalogue& catalogue) const;
+    void PlanLevelOfDetail(const SphereProjector& projector, const tc::TransportCatalogue& catalogue, MapItems& items) const;
+
+    // Слои карты строятся по одному объекту: каждый готовый объект передаётся в emit.
+    // Строится часть слоя для элементов списка с номерами [begin, end)
+    template <typename Emit>
+    void EmitRouteLines(const SphereProjector& projector, const tc::TransportCatalogue& catalogue,
+                        const MapItems& items, size_t begin, size_t end, Emit&& emit) const;
+    template <typename Emit>
+    void EmitBusNames(const SphereProjector& projector, const tc::TransportCatalogue& catalogue,
+                      const MapItems& items, size_t begin, size_t end, Emit&& emit) const;
+    template <typename Emit>
+    void EmitStopCircles(const SphereProjector& projector, const MapItems& items,
+                         size_t begin, size_t end, Emit&& emit) const;
+    template <typename Emit>
+    void EmitStopNames(const SphereProjector& projector, const MapItems& items,
+                       size_t begin, size_t end, Emit&& emit) const;
+
     RenderSettings render_settings_;
 };
 
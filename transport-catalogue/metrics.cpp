@@ -0,0 +1,170 @@
+#include "metrics.h"
+
+#ifdef TC_METRICS
+
+#include "json.h"
+#include "json_builder.h"
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+std::atomic<uint64_t> allocated_bytes{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Через выровненный operator new память берёт std::pmr::new_delete_resource, а за ним
+// все арены и pmr-контейнеры JSON
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    // Размер для aligned_alloc должен быть кратен выравниванию
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align + (size == 0 ? align : 0))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+namespace metrics {
+
+namespace {
+
+using namespace std::literals;
+
+// Счётчики выводятся целыми, пока помещаются в int
+json::Node CountNode(uint64_t value) {
+    if (value <= static_cast<uint64_t>(INT_MAX)) {
+        return static_cast<int>(value);
+    }
+    return static_cast<double>(value);
+}
+
+double ToMilliseconds(uint64_t ns) {
+    return static_cast<double>(ns) / 1'000'000;
+}
+
+// Имена метрик Prometheus допускают только [a-zA-Z0-9_]
+std::string PrometheusName(std::string_view name) {
+    std::string result = "tc_"s;
+    for (const char c : name) {
+        result.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+    return result;
+}
+
+}  // namespace
+
+uint64_t GetAllocationCount() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t GetAllocatedBytes() {
+    return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+Registry& Registry::Instance() {
+    static Registry registry;
+    return registry;
+}
+
+TimerStat& Registry::GetTimer(std::string_view name) {
+    std::lock_guard lock(mutex_);
+    auto it = timers_.find(name);
+    if (it == timers_.end()) {
+        it = timers_.try_emplace(std::string(name)).first;
+    }
+    return it->second;
+}
+
+Counter& Registry::GetCounter(std::string_view name) {
+    std::lock_guard lock(mutex_);
+    auto it = counters_.find(name);
+    if (it == counters_.end()) {
+        it = counters_.try_emplace(std::string(name), 0).first;
+    }
+    return it->second;
+}
+
+void Registry::PrintJson(std::ostream& out) const {
+    // Под блокировкой только собирается узел: печать JSON сама инструментирована,
+    // и её первый замер взял бы ту же блокировку в GetTimer
+    std::unique_lock lock(mutex_);
+    json::Builder builder;
+    builder.StartDict().Key("timers").StartDict();
+    for (const auto& [name, stat] : timers_) {
+        builder.Key(name).StartDict()
+                   .Key("count").Value(CountNode(stat.count).GetValue())
+                   .Key("total_ms").Value(ToMilliseconds(stat.total_ns))
+                   .Key("max_ms").Value(ToMilliseconds(stat.max_ns))
+                   .Key("allocations").Value(CountNode(stat.allocations).GetValue())
+               .EndDict();
+    }
+    builder.EndDict().Key("counters").StartDict();
+    for (const auto& [name, counter] : counters_) {
+        builder.Key(name).Value(CountNode(counter).GetValue());
+    }
+    builder.EndDict()
+           .Key("allocations").Value(CountNode(GetAllocationCount()).GetValue())
+           .Key("allocated_bytes").Value(CountNode(GetAllocatedBytes()).GetValue())
+           .EndDict();
+    const json::Node report = builder.Build();
+    lock.unlock();
+    json::Print(report, out, 0);
+}
+
+void Registry::PrintPrometheus(std::ostream& out) const {
+    std::lock_guard lock(mutex_);
+    for (const auto& [name, stat] : timers_) {
+        const std::string metric = PrometheusName(name);
+        out << "# TYPE "sv << metric << "_seconds summary\n"sv;
+        out << metric << "_seconds_count "sv << stat.count << '\n';
+        out << metric << "_seconds_sum "sv << static_cast<double>(stat.total_ns) / 1e9 << '\n';
+        out << "# TYPE "sv << metric << "_max_seconds gauge\n"sv;
+        out << metric << "_max_seconds "sv << static_cast<double>(stat.max_ns) / 1e9 << '\n';
+        out << "# TYPE "sv << metric << "_allocations_total counter\n"sv;
+        out << metric << "_allocations_total "sv << stat.allocations << '\n';
+    }
+    for (const auto& [name, counter] : counters_) {
+        const std::string metric = PrometheusName(name);
+        out << "# TYPE "sv << metric << "_total counter\n"sv;
+        out << metric << "_total "sv << counter << '\n';
+    }
+    out << "# TYPE tc_allocations_total counter\n"sv;
+    out << "tc_allocations_total "sv << GetAllocationCount() << '\n';
+    out << "# TYPE tc_allocated_bytes_total counter\n"sv;
+    out << "tc_allocated_bytes_total "sv << GetAllocatedBytes() << '\n';
+}
+
+}  // namespace metrics
+
+#endif
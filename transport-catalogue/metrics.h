@@ -0,0 +1,104 @@
+#pragma once
+
+// Инструментирование горячих участков. Включается определением TC_METRICS при сборке,
+// без него макросы ниже раскрываются в пустоту и не оставляют следа в коде
+
+#ifdef TC_METRICS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace metrics {
+
+struct TimerStat {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> allocations{0};
+};
+
+using Counter = std::atomic<uint64_t>;
+
+// Число вызовов operator new с начала работы программы
+uint64_t GetAllocationCount();
+uint64_t GetAllocatedBytes();
+
+class Registry {
+public:
+    static Registry& Instance();
+
+    // Ссылки стабильны: точки замера запоминают их один раз и дальше обходятся без блокировок
+    TimerStat& GetTimer(std::string_view name);
+    Counter& GetCounter(std::string_view name);
+
+    void PrintJson(std::ostream& out) const;
+    void PrintPrometheus(std::ostream& out) const;
+
+private:
+    Registry() = default;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, TimerStat, std::less<>> timers_;
+    std::map<std::string, Counter, std::less<>> counters_;
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(TimerStat& stat)
+        : stat_(stat)
+        , allocations_(GetAllocationCount())
+        , start_(std::chrono::steady_clock::now()) {
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        stat_.count.fetch_add(1, std::memory_order_relaxed);
+        stat_.total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+        stat_.allocations.fetch_add(GetAllocationCount() - allocations_, std::memory_order_relaxed);
+        uint64_t max_ns = stat_.max_ns.load(std::memory_order_relaxed);
+        while (elapsed > max_ns && !stat_.max_ns.compare_exchange_weak(max_ns, elapsed, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    TimerStat& stat_;
+    uint64_t allocations_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace metrics
+
+#define TC_METRICS_CONCAT_IMPL(a, b) a##b
+#define TC_METRICS_CONCAT(a, b) TC_METRICS_CONCAT_IMPL(a, b)
+
+// Замеряет время и число выделений памяти до конца текущей области видимости
+#define TC_METRICS_SCOPE(name)                                                                    \
+    static ::metrics::TimerStat& TC_METRICS_CONCAT(tc_metrics_stat_, __LINE__) =                  \
+        ::metrics::Registry::Instance().GetTimer(name);                                           \
+    ::metrics::ScopedTimer TC_METRICS_CONCAT(tc_metrics_timer_, __LINE__)(                        \
+        TC_METRICS_CONCAT(tc_metrics_stat_, __LINE__))
+
+// Увеличивает счётчик name на value
+#define TC_METRICS_COUNT(name, value)                                                             \
+    do {                                                                                          \
+        static ::metrics::Counter& tc_metrics_counter = ::metrics::Registry::Instance().GetCounter(name); \
+        tc_metrics_counter.fetch_add(value, std::memory_order_relaxed);                           \
+    } while (false)
+
+#else
+
+#define TC_METRICS_SCOPE(name)
+#define TC_METRICS_COUNT(name, value) do {} while (false)
+
+#endif
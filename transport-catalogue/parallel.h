@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace par {
+
+// Число кусков, на которые делится диапазон из count элементов: не больше числа ядер
+// и так, чтобы в каждом куске было не меньше min_chunk элементов
+inline size_t GetChunkCount(size_t count, size_t min_chunk) {
+    const size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t chunks = (count + min_chunk - 1) / std::max<size_t>(1, min_chunk);
+    return std::clamp<size_t>(chunks, 1, threads);
+}
+
+// Делит [0, count) на GetChunkCount(count, min_chunk) непрерывных кусков и вызывает
+// func(chunk_index, begin, end) для каждого из них в отдельном потоке.
+// Куски идут по порядку, поэтому результаты, собранные по chunk_index,
+// можно склеить детерминированно. Исключения из потоков пробрасываются вызывающему
+template <typename Func>
+void ForEachChunk(size_t count, size_t min_chunk, Func func) {
+    const size_t chunk_count = GetChunkCount(count, min_chunk);
+    const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(chunk_count - 1);
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        const size_t begin = std::min(count, chunk * chunk_size);
+        const size_t end = std::min(count, begin + chunk_size);
+        tasks.push_back(std::async(std::launch::async, [&func, chunk, begin, end] {
+            func(chunk, begin, end);
+        }));
+    }
+    func(size_t{0}, size_t{0}, std::min(count, chunk_size));
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+// Точка встречи count потоков: Wait возвращается, когда его вызвали все потоки.
+// Барьер можно проходить многократно
+class Barrier {
+public:
+    explicit Barrier(size_t count)
+        : count_(count) {
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, generation] {
+            return generation != generation_;
+        });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
+
+}  // namespace par
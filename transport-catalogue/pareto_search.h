@@ -0,0 +1,146 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск путей, не доминируемых по паре (вес пути, число рёбер), раундами:
+// в раунде k находятся пути ровно из k рёбер, которые легче всех путей из меньшего числа рёбер.
+// Метки, не улучшающие уже найденный вес до вершины или до цели, отбрасываются сразу,
+// поэтому на каждую вершину приходится не больше одной метки за раунд.
+// Рабочие массивы переиспользуются между запусками
+template <typename Weight>
+class ParetoSearch {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    explicit ParetoSearch(const Graph& graph);
+
+    // Пути из from в to в порядке возрастания числа рёбер и убывания веса.
+    // Пути длиннее max_edges рёбер не рассматриваются
+    std::vector<std::vector<EdgeId>> Run(VertexId from, VertexId to,
+                                         size_t max_edges = std::numeric_limits<size_t>::max());
+
+private:
+    static constexpr EdgeId NONE = std::numeric_limits<EdgeId>::max();
+
+    void Reset();
+    std::vector<EdgeId> BuildPath(VertexId from, VertexId to, size_t round) const;
+
+    const Graph& graph_;
+    std::vector<Weight> best_;
+    std::vector<bool> reached_;
+    std::vector<bool> marked_;
+    std::vector<VertexId> touched_;
+    // Вершины, улучшенные в прошлом раунде, с весом на его конец
+    std::vector<std::pair<VertexId, Weight>> frontier_;
+    std::vector<VertexId> next_frontier_;
+    // labels_[k * V + v] - последнее ребро пути из k рёбер, улучшившего вес до v
+    std::vector<EdgeId> labels_;
+};
+
+template <typename Weight>
+ParetoSearch<Weight>::ParetoSearch(const Graph& graph)
+    : graph_(graph)
+    , best_(graph.GetVertexCount())
+    , reached_(graph.GetVertexCount(), false)
+    , marked_(graph.GetVertexCount(), false) {
+}
+
+template <typename Weight>
+void ParetoSearch<Weight>::Reset() {
+    for (const VertexId vertex : touched_) {
+        reached_[vertex] = false;
+    }
+    touched_.clear();
+    frontier_.clear();
+    next_frontier_.clear();
+    labels_.clear();
+}
+
+template <typename Weight>
+std::vector<std::vector<EdgeId>> ParetoSearch<Weight>::Run(VertexId from, VertexId to, size_t max_edges) {
+    Reset();
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<std::vector<EdgeId>> paths;
+    if (from == to) {
+        paths.emplace_back();
+        return paths;
+    }
+
+    best_.at(from) = Weight{};
+    reached_[from] = true;
+    touched_.push_back(from);
+    frontier_.push_back({from, Weight{}});
+    labels_.assign(vertex_count, NONE);
+
+    std::vector<size_t> target_rounds;
+    for (size_t round = 1; round <= max_edges && !frontier_.empty(); ++round) {
+        labels_.resize((round + 1) * vertex_count, NONE);
+        EdgeId* labels = &labels_[round * vertex_count];
+        for (const auto& [vertex, weight] : frontier_) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                Weight candidate = weight + edge.weight;
+                if ((reached_[edge.to] && !(candidate < best_[edge.to]))
+                    || (reached_[to] && !(candidate < best_[to]))) {
+                    continue;
+                }
+                if (!reached_[edge.to]) {
+                    reached_[edge.to] = true;
+                    touched_.push_back(edge.to);
+                }
+                best_[edge.to] = std::move(candidate);
+                labels[edge.to] = edge_id;
+                if (!marked_[edge.to]) {
+                    marked_[edge.to] = true;
+                    next_frontier_.push_back(edge.to);
+                }
+            }
+        }
+        if (labels[to] != NONE) {
+            target_rounds.push_back(round);
+        }
+
+        // Из цели пути дальше не продолжаются: они не могут стать легче уже найденного
+        frontier_.clear();
+        for (const VertexId vertex : next_frontier_) {
+            marked_[vertex] = false;
+            if (vertex != to) {
+                frontier_.push_back({vertex, best_[vertex]});
+            }
+        }
+        next_frontier_.clear();
+    }
+
+    paths.reserve(target_rounds.size());
+    for (const size_t round : target_rounds) {
+        paths.push_back(BuildPath(from, to, round));
+    }
+    return paths;
+}
+
+template <typename Weight>
+std::vector<EdgeId> ParetoSearch<Weight>::BuildPath(VertexId from, VertexId to, size_t round) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<EdgeId> edges;
+    // Метка раунда k опирается на последнюю метку предыдущей вершины не позже раунда k - 1
+    for (VertexId vertex = to; vertex != from; --round) {
+        while (labels_[round * vertex_count + vertex] == NONE) {
+            --round;
+        }
+        const EdgeId edge_id = labels_[round * vertex_count + vertex];
+        edges.push_back(edge_id);
+        vertex = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+}  // namespace graph
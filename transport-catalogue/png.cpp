@@ -0,0 +1,142 @@
+#include "png.h"
+#include "deflate.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace png {
+
+namespace {
+
+constexpr size_t BYTES_PER_PIXEL = 4;
+
+void AppendUint32(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void WriteChunk(std::ostream& out, std::string_view type, std::string_view data) {
+    std::string header;
+    AppendUint32(header, static_cast<uint32_t>(data.size()));
+    header.append(type);
+    out.write(header.data(), header.size());
+    out.write(data.data(), data.size());
+    std::string crc;
+    AppendUint32(crc, deflate::Crc32(data, deflate::Crc32(type)));
+    out.write(crc.data(), crc.size());
+}
+
+uint8_t Paeth(uint8_t left, uint8_t up, uint8_t up_left) {
+    const int estimate = left + up - up_left;
+    const int to_left = std::abs(estimate - left);
+    const int to_up = std::abs(estimate - up);
+    const int to_up_left = std::abs(estimate - up_left);
+    if (to_left <= to_up && to_left <= to_up_left) {
+        return left;
+    }
+    return to_up <= to_up_left ? up : up_left;
+}
+
+// Строка после фильтра type (0 - без фильтра, 1 - Sub, 2 - Up, 3 - Average, 4 - Paeth)
+// с байтом фильтра в начале. Для первой строки prev заполнен нулями
+void FilterRow(int type, const uint8_t* row, const uint8_t* prev, size_t size, std::string& out) {
+    out.assign(1, static_cast<char>(type));
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t left = i >= BYTES_PER_PIXEL ? row[i - BYTES_PER_PIXEL] : 0;
+        const uint8_t up_left = i >= BYTES_PER_PIXEL ? prev[i - BYTES_PER_PIXEL] : 0;
+        uint8_t predicted = 0;
+        switch (type) {
+        case 1:
+            predicted = left;
+            break;
+        case 2:
+            predicted = prev[i];
+            break;
+        case 3:
+            predicted = static_cast<uint8_t>((left + prev[i]) / 2);
+            break;
+        case 4:
+            predicted = Paeth(left, prev[i], up_left);
+            break;
+        }
+        out.push_back(static_cast<char>(row[i] - predicted));
+    }
+}
+
+// Обычная эвристика выбора фильтра: наименьшая сумма модулей байтов как знаковых чисел
+uint64_t GetFilterCost(const std::string& filtered) {
+    uint64_t cost = 0;
+    for (size_t i = 1; i < filtered.size(); ++i) {
+        cost += std::abs(static_cast<int>(static_cast<int8_t>(filtered[i])));
+    }
+    return cost;
+}
+
+}  // namespace
+
+void Write(std::ostream& out, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels) {
+    static constexpr std::string_view SIGNATURE = "\x89PNG\r\n\x1A\n";
+    out.write(SIGNATURE.data(), SIGNATURE.size());
+
+    std::string header;
+    AppendUint32(header, width);
+    AppendUint32(header, height);
+    // 8 бит на канал, цвет RGBA, стандартные сжатие и фильтрация, без чересстрочности
+    header.append({8, 6, 0, 0, 0});
+    WriteChunk(out, "IHDR", header);
+
+    // Отфильтрованные строки сразу уходят в поток zlib, целиком изображение не копируется
+    std::ostringstream compressed;
+    compressed.write("\x78\x9C", 2);
+    uint32_t adler = 1;
+    {
+        deflate::Compressor compressor(compressed);
+        const size_t row_size = size_t{width} * BYTES_PER_PIXEL;
+        const std::vector<uint8_t> zero_row(row_size);
+        std::string best;
+        std::string candidate;
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint8_t* row = pixels.data() + y * row_size;
+            const uint8_t* prev = y == 0 ? zero_row.data() : row - row_size;
+            FilterRow(0, row, prev, row_size, best);
+            uint64_t best_cost = GetFilterCost(best);
+            for (int type = 1; type <= 4; ++type) {
+                FilterRow(type, row, prev, row_size, candidate);
+                const uint64_t cost = GetFilterCost(candidate);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best.swap(candidate);
+                }
+            }
+            compressor.Write(best);
+            adler = deflate::Adler32(best, adler);
+        }
+        compressor.Finish();
+    }
+    std::string data = compressed.str();
+    AppendUint32(data, adler);
+    WriteChunk(out, "IDAT", data);
+    WriteChunk(out, "IEND", {});
+}
+
+std::string ToDataUri(std::string_view png) {
+    static constexpr std::string_view ALPHABET =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result = "data:image/png;base64,";
+    result.reserve(result.size() + (png.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < png.size(); i += 3) {
+        const size_t count = std::min<size_t>(3, png.size() - i);
+        uint32_t group = 0;
+        for (size_t j = 0; j < 3; ++j) {
+            group = group << 8 | (j < count ? static_cast<uint8_t>(png[i + j]) : 0);
+        }
+        for (size_t j = 0; j < 4; ++j) {
+            result.push_back(j <= count ? ALPHABET[(group >> (18 - 6 * j)) & 0x3F] : '=');
+        }
+    }
+    return result;
+}
+
+}  // namespace png
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace png {
+
+// Записывает изображение в формате PNG: 8 бит на канал RGBA, без чересстрочности.
+// pixels - строки изображения сверху вниз, по четыре байта на пиксель
+void Write(std::ostream& out, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels);
+
+// Ссылка data: с изображением PNG в base64, пригодная для вставки в JSON и HTML
+std::string ToDataUri(std::string_view png);
+
+}  // namespace png
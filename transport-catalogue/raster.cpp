@@ -0,0 +1,522 @@
+#include "raster.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <string_view>
+
+namespace raster {
+
+namespace {
+
+// Глифы шрифта 5x7 записаны по столбцам слева направо, младший бит - верхняя строка
+constexpr int GLYPH_WIDTH = 5;
+constexpr int GLYPH_HEIGHT = 7;
+// Ширина символа вместе с промежутком и размер шрифта в клетках глифа:
+// при таком размере высота заглавных букв близка к Verdana
+constexpr int GLYPH_ADVANCE = 6;
+constexpr double FONT_SIZE_CELLS = 9.0;
+
+// Символы с кодами 0x20-0x7E
+constexpr uint8_t ASCII_GLYPHS[95][GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00},  // пробел
+    {0x00, 0x00, 0x5F, 0x00, 0x00},  // !
+    {0x00, 0x07, 0x00, 0x07, 0x00},  // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14},  // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12},  // $
+    {0x23, 0x13, 0x08, 0x64, 0x62},  // %
+    {0x36, 0x49, 0x55, 0x22, 0x50},  // &
+    {0x00, 0x05, 0x03, 0x00, 0x00},  // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00},  // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00},  // )
+    {0x08, 0x2A, 0x1C, 0x2A, 0x08},  // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08},  // +
+    {0x00, 0x50, 0x30, 0x00, 0x00},  // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08},  // -
+    {0x00, 0x60, 0x60, 0x00, 0x00},  // .
+    {0x20, 0x10, 0x08, 0x04, 0x02},  // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E},  // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00},  // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46},  // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31},  // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10},  // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39},  // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30},  // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03},  // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36},  // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E},  // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00},  // :
+    {0x00, 0x56, 0x36, 0x00, 0x00},  // ;
+    {0x08, 0x14, 0x22, 0x41, 0x00},  // <
+    {0x14, 0x14, 0x14, 0x14, 0x14},  // =
+    {0x00, 0x41, 0x22, 0x14, 0x08},  // >
+    {0x02, 0x01, 0x51, 0x09, 0x06},  // ?
+    {0x32, 0x49, 0x79, 0x41, 0x3E},  // @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E},  // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36},  // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22},  // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C},  // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41},  // E
+    {0x7F, 0x09, 0x09, 0x01, 0x01},  // F
+    {0x3E, 0x41, 0x41, 0x51, 0x32},  // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F},  // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00},  // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01},  // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41},  // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40},  // L
+    {0x7F, 0x02, 0x04, 0x02, 0x7F},  // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F},  // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E},  // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06},  // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E},  // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46},  // R
+    {0x46, 0x49, 0x49, 0x49, 0x31},  // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01},  // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F},  // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F},  // V
+    {0x7F, 0x20, 0x18, 0x20, 0x7F},  // W
+    {0x63, 0x14, 0x08, 0x14, 0x63},  // X
+    {0x03, 0x04, 0x78, 0x04, 0x03},  // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43},  // Z
+    {0x00, 0x00, 0x7F, 0x41, 0x41},  // [
+    {0x02, 0x04, 0x08, 0x10, 0x20},  // backslash
+    {0x41, 0x41, 0x7F, 0x00, 0x00},  // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04},  // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40},  // _
+    {0x00, 0x01, 0x02, 0x04, 0x00},  // `
+    {0x20, 0x54, 0x54, 0x54, 0x78},  // a
+    {0x7F, 0x48, 0x44, 0x44, 0x38},  // b
+    {0x38, 0x44, 0x44, 0x44, 0x20},  // c
+    {0x38, 0x44, 0x44, 0x48, 0x7F},  // d
+    {0x38, 0x54, 0x54, 0x54, 0x18},  // e
+    {0x08, 0x7E, 0x09, 0x01, 0x02},  // f
+    {0x08, 0x14, 0x54, 0x54, 0x3C},  // g
+    {0x7F, 0x08, 0x04, 0x04, 0x78},  // h
+    {0x00, 0x44, 0x7D, 0x40, 0x00},  // i
+    {0x20, 0x40, 0x44, 0x3D, 0x00},  // j
+    {0x00, 0x7F, 0x10, 0x28, 0x44},  // k
+    {0x00, 0x41, 0x7F, 0x40, 0x00},  // l
+    {0x7C, 0x04, 0x18, 0x04, 0x78},  // m
+    {0x7C, 0x08, 0x04, 0x04, 0x78},  // n
+    {0x38, 0x44, 0x44, 0x44, 0x38},  // o
+    {0x7C, 0x14, 0x14, 0x14, 0x08},  // p
+    {0x08, 0x14, 0x14, 0x18, 0x7C},  // q
+    {0x7C, 0x08, 0x04, 0x04, 0x08},  // r
+    {0x48, 0x54, 0x54, 0x54, 0x20},  // s
+    {0x04, 0x3F, 0x44, 0x40, 0x20},  // t
+    {0x3C, 0x40, 0x40, 0x20, 0x7C},  // u
+    {0x1C, 0x20, 0x40, 0x20, 0x1C},  // v
+    {0x3C, 0x40, 0x30, 0x40, 0x3C},  // w
+    {0x44, 0x28, 0x10, 0x28, 0x44},  // x
+    {0x0C, 0x50, 0x50, 0x50, 0x3C},  // y
+    {0x44, 0x64, 0x54, 0x4C, 0x44},  // z
+    {0x00, 0x08, 0x36, 0x41, 0x00},  // {
+    {0x00, 0x00, 0x7F, 0x00, 0x00},  // |
+    {0x00, 0x41, 0x36, 0x08, 0x00},  // }
+    {0x08, 0x04, 0x08, 0x10, 0x08},  // ~
+};
+
+// Буквы А-я, U+0410-U+044F
+constexpr uint8_t CYRILLIC_GLYPHS[64][GLYPH_WIDTH] = {
+    {0x7E, 0x11, 0x11, 0x11, 0x7E},  // А
+    {0x7F, 0x49, 0x49, 0x49, 0x31},  // Б
+    {0x7F, 0x49, 0x49, 0x49, 0x36},  // В
+    {0x7F, 0x01, 0x01, 0x01, 0x01},  // Г
+    {0x60, 0x3F, 0x21, 0x3F, 0x60},  // Д
+    {0x7F, 0x49, 0x49, 0x49, 0x41},  // Е
+    {0x63, 0x14, 0x7F, 0x14, 0x63},  // Ж
+    {0x22, 0x41, 0x49, 0x49, 0x36},  // З
+    {0x7F, 0x10, 0x08, 0x04, 0x7F},  // И
+    {0x7E, 0x10, 0x09, 0x04, 0x7E},  // Й
+    {0x7F, 0x08, 0x14, 0x22, 0x41},  // К
+    {0x40, 0x3E, 0x01, 0x01, 0x7F},  // Л
+    {0x7F, 0x02, 0x04, 0x02, 0x7F},  // М
+    {0x7F, 0x08, 0x08, 0x08, 0x7F},  // Н
+    {0x3E, 0x41, 0x41, 0x41, 0x3E},  // О
+    {0x7F, 0x01, 0x01, 0x01, 0x7F},  // П
+    {0x7F, 0x09, 0x09, 0x09, 0x06},  // Р
+    {0x3E, 0x41, 0x41, 0x41, 0x22},  // С
+    {0x01, 0x01, 0x7F, 0x01, 0x01},  // Т
+    {0x27, 0x48, 0x48, 0x48, 0x3F},  // У
+    {0x1C, 0x22, 0x7F, 0x22, 0x1C},  // Ф
+    {0x63, 0x14, 0x08, 0x14, 0x63},  // Х
+    {0x3F, 0x20, 0x20, 0x3F, 0x60},  // Ц
+    {0x07, 0x08, 0x08, 0x08, 0x7F},  // Ч
+    {0x7F, 0x40, 0x7F, 0x40, 0x7F},  // Ш
+    {0x3F, 0x20, 0x3F, 0x20, 0x7F},  // Щ
+    {0x01, 0x7F, 0x48, 0x48, 0x30},  // Ъ
+    {0x7F, 0x48, 0x30, 0x00, 0x7F},  // Ы
+    {0x7F, 0x48, 0x48, 0x48, 0x30},  // Ь
+    {0x22, 0x41, 0x49, 0x49, 0x3E},  // Э
+    {0x7F, 0x08, 0x3E, 0x41, 0x3E},  // Ю
+    {0x46, 0x29, 0x19, 0x09, 0x7F},  // Я
+    {0x20, 0x54, 0x54, 0x54, 0x78},  // а
+    {0x3E, 0x45, 0x45, 0x45, 0x38},  // б
+    {0x7C, 0x54, 0x54, 0x54, 0x28},  // в
+    {0x7C, 0x04, 0x04, 0x04, 0x04},  // г
+    {0x60, 0x3C, 0x24, 0x3C, 0x60},  // д
+    {0x38, 0x54, 0x54, 0x54, 0x18},  // е
+    {0x44, 0x28, 0x7C, 0x28, 0x44},  // ж
+    {0x44, 0x54, 0x54, 0x54, 0x28},  // з
+    {0x7C, 0x20, 0x10, 0x08, 0x7C},  // и
+    {0x7C, 0x20, 0x12, 0x08, 0x7C},  // й
+    {0x7C, 0x10, 0x28, 0x44, 0x00},  // к
+    {0x40, 0x38, 0x04, 0x04, 0x7C},  // л
+    {0x7C, 0x08, 0x10, 0x08, 0x7C},  // м
+    {0x7C, 0x10, 0x10, 0x10, 0x7C},  // н
+    {0x38, 0x44, 0x44, 0x44, 0x38},  // о
+    {0x7C, 0x04, 0x04, 0x04, 0x7C},  // п
+    {0x7C, 0x14, 0x14, 0x14, 0x08},  // р
+    {0x38, 0x44, 0x44, 0x44, 0x20},  // с
+    {0x04, 0x04, 0x7C, 0x04, 0x04},  // т
+    {0x0C, 0x50, 0x50, 0x50, 0x3C},  // у
+    {0x18, 0x24, 0x7E, 0x24, 0x18},  // ф
+    {0x44, 0x28, 0x10, 0x28, 0x44},  // х
+    {0x3C, 0x20, 0x20, 0x3C, 0x60},  // ц
+    {0x0C, 0x10, 0x10, 0x10, 0x7C},  // ч
+    {0x7C, 0x40, 0x7C, 0x40, 0x7C},  // ш
+    {0x3C, 0x20, 0x3C, 0x20, 0x7C},  // щ
+    {0x04, 0x7C, 0x50, 0x50, 0x20},  // ъ
+    {0x7C, 0x50, 0x20, 0x00, 0x7C},  // ы
+    {0x7C, 0x50, 0x50, 0x50, 0x20},  // ь
+    {0x28, 0x44, 0x54, 0x54, 0x38},  // э
+    {0x7C, 0x10, 0x38, 0x44, 0x38},  // ю
+    {0x48, 0x34, 0x14, 0x14, 0x7C},  // я
+};
+
+// Ё и ё, U+0401 и U+0451
+constexpr uint8_t YO_GLYPHS[2][GLYPH_WIDTH] = {
+    {0x7E, 0x4B, 0x4A, 0x4B, 0x42},  // Ё
+    {0x38, 0x55, 0x54, 0x55, 0x18},  // ё
+};
+
+// Пустой прямоугольник для символов, которых нет в шрифте
+constexpr uint8_t MISSING_GLYPH[GLYPH_WIDTH] = {0x7F, 0x41, 0x41, 0x41, 0x7F};
+
+const uint8_t* FindGlyph(char32_t code) {
+    if (code >= 0x20 && code < 0x7F) {
+        return ASCII_GLYPHS[code - 0x20];
+    }
+    if (code >= 0x410 && code < 0x450) {
+        return CYRILLIC_GLYPHS[code - 0x410];
+    }
+    if (code == 0x401 || code == 0x451) {
+        return YO_GLYPHS[code == 0x401 ? 0 : 1];
+    }
+    return MISSING_GLYPH;
+}
+
+// Очередной символ строки UTF-8. Неверная последовательность даёт один символ
+// с кодом 0, которого нет в шрифте
+char32_t DecodeUtf8(std::string_view text, size_t& pos) {
+    const uint8_t lead = static_cast<uint8_t>(text[pos++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+    const int tail = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    if (tail == 0 || pos + tail > text.size()) {
+        return 0;
+    }
+    char32_t code = lead & (0x3F >> tail);
+    for (int i = 0; i < tail; ++i) {
+        const uint8_t byte = static_cast<uint8_t>(text[pos]);
+        if ((byte & 0xC0) != 0x80) {
+            return 0;
+        }
+        code = code << 6 | (byte & 0x3F);
+        ++pos;
+    }
+    return code;
+}
+
+struct NamedColor {
+    std::string_view name;
+    uint32_t rgb;
+};
+
+// Часто используемые имена цветов CSS
+constexpr NamedColor NAMED_COLORS[] = {
+    {"aqua", 0x00FFFF}, {"black", 0x000000}, {"blue", 0x0000FF}, {"brown", 0xA52A2A},
+    {"cyan", 0x00FFFF}, {"darkblue", 0x00008B}, {"darkgreen", 0x006400}, {"darkred", 0x8B0000},
+    {"fuchsia", 0xFF00FF}, {"gold", 0xFFD700}, {"gray", 0x808080}, {"green", 0x008000},
+    {"grey", 0x808080}, {"indigo", 0x4B0082}, {"lightblue", 0xADD8E6}, {"lightgray", 0xD3D3D3},
+    {"lightgreen", 0x90EE90}, {"lightgrey", 0xD3D3D3}, {"lime", 0x00FF00}, {"magenta", 0xFF00FF},
+    {"maroon", 0x800000}, {"navy", 0x000080}, {"olive", 0x808000}, {"orange", 0xFFA500},
+    {"pink", 0xFFC0CB}, {"purple", 0x800080}, {"red", 0xFF0000}, {"silver", 0xC0C0C0},
+    {"teal", 0x008080}, {"violet", 0xEE82EE}, {"white", 0xFFFFFF}, {"yellow", 0xFFFF00},
+};
+
+// Цвет по имени CSS или в виде #rgb и #rrggbb. Неизвестный цвет считается чёрным
+uint32_t ParseColorName(std::string_view name) {
+    if (!name.empty() && name.front() == '#' && (name.size() == 4 || name.size() == 7)) {
+        uint32_t rgb = 0;
+        for (const char c : name.substr(1)) {
+            const int digit = std::isdigit(static_cast<unsigned char>(c)) ? c - '0'
+                              : std::isxdigit(static_cast<unsigned char>(c)) ? std::tolower(c) - 'a' + 10
+                                                                               : 0;
+            rgb = rgb << (name.size() == 4 ? 8 : 4) | digit * (name.size() == 4 ? 17 : 1);
+        }
+        return rgb;
+    }
+    for (const NamedColor& color : NAMED_COLORS) {
+        if (color.name == name) {
+            return color.rgb;
+        }
+    }
+    return 0;
+}
+
+double Clamp01(double value) {
+    return std::clamp(value, 0.0, 1.0);
+}
+
+}  // namespace
+
+Canvas::Canvas(uint32_t width, uint32_t height)
+    : width_(width)
+    , height_(height)
+    , pixels_(size_t{width} * height * 4) {
+}
+
+uint32_t Canvas::GetWidth() const {
+    return width_;
+}
+
+uint32_t Canvas::GetHeight() const {
+    return height_;
+}
+
+const std::vector<uint8_t>& Canvas::GetPixels() const {
+    return pixels_;
+}
+
+Painter::Painter(Canvas& canvas, uint32_t row_begin, uint32_t row_end)
+    : canvas_(canvas)
+    , row_begin_(std::min(row_begin, canvas.height_))
+    , row_end_(std::clamp(row_end, row_begin_, canvas.height_))
+    , mask_(size_t{canvas.width_} * (row_end_ - row_begin_)) {
+}
+
+void Painter::Draw(const svg::Polyline& polyline) {
+    Color color;
+    // Заливка ломаных не рисуется: на карте они всегда без заливки
+    if (!GetColor(polyline.GetStrokeColor(), Color{}, color)) {
+        return;
+    }
+    const std::vector<svg::Point>& points = polyline.GetPoints();
+    const double radius = polyline.GetStrokeWidth().value_or(1.0) / 2;
+    if (points.size() == 1) {
+        CoverSegment(points.front(), points.front(), radius);
+    }
+    for (size_t i = 1; i < points.size(); ++i) {
+        CoverSegment(points[i - 1], points[i], radius);
+    }
+    Fill(color);
+}
+
+void Painter::Draw(const svg::Circle& circle) {
+    Color color;
+    if (GetColor(circle.GetFillColor(), Color{0, 0, 0, 1}, color)) {
+        CoverSegment(circle.GetCenter(), circle.GetCenter(), circle.GetRadius());
+        Fill(color);
+    }
+    if (GetColor(circle.GetStrokeColor(), Color{}, color)) {
+        CoverRing(circle.GetCenter(), circle.GetRadius(), circle.GetStrokeWidth().value_or(1.0) / 2);
+        Fill(color);
+    }
+}
+
+void Painter::Draw(const svg::Text& text) {
+    Color color;
+    if (GetColor(text.GetFillColor(), Color{0, 0, 0, 1}, color)) {
+        CoverText(text, 0);
+        Fill(color);
+    }
+    if (GetColor(text.GetStrokeColor(), Color{}, color)) {
+        CoverText(text, text.GetStrokeWidth().value_or(1.0) / 2);
+        Fill(color);
+    }
+}
+
+void Painter::Cover(uint32_t x, uint32_t y, double coverage) {
+    if (coverage <= 0) {
+        return;
+    }
+    const uint32_t index = (y - row_begin_) * canvas_.width_ + x;
+    float& value = mask_[index];
+    if (value == 0) {
+        covered_.push_back(index);
+    }
+    value = std::max(value, static_cast<float>(coverage));
+}
+
+void Painter::CoverSegment(svg::Point from, svg::Point to, double radius) {
+    // Покрытие пикселя - доля круга радиусом в полпикселя вокруг его центра,
+    // попавшая в линию, приближённо по расстоянию от центра до отрезка.
+    // Линии тоньше пикселя становятся бледнее, а не толще
+    const double reach = radius + 0.5;
+    const double weight = std::min(1.0, 2 * radius);
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double length_squared = dx * dx + dy * dy;
+    const double top = std::max<double>(row_begin_, std::floor(std::min(from.y, to.y) - reach));
+    const double bottom = std::min<double>(row_end_, std::ceil(std::max(from.y, to.y) + reach));
+    for (double y = top; y < bottom; ++y) {
+        const double center_y = y + 0.5;
+        // Отрезок проходит через строку при параметрах [t_begin, t_end]
+        double t_begin = 0;
+        double t_end = 1;
+        if (std::abs(dy) > 1e-9) {
+            t_begin = (center_y - reach - from.y) / dy;
+            t_end = (center_y + reach - from.y) / dy;
+            if (t_begin > t_end) {
+                std::swap(t_begin, t_end);
+            }
+            t_begin = std::max(0.0, t_begin);
+            t_end = std::min(1.0, t_end);
+            if (t_begin > t_end) {
+                continue;
+            }
+        } else if (std::abs(center_y - from.y) > reach) {
+            continue;
+        }
+        const double x_begin = from.x + dx * t_begin;
+        const double x_end = from.x + dx * t_end;
+        const double left = std::max(0.0, std::floor(std::min(x_begin, x_end) - reach));
+        const double right = std::min<double>(canvas_.width_, std::ceil(std::max(x_begin, x_end) + reach));
+        for (double x = left; x < right; ++x) {
+            const double center_x = x + 0.5;
+            double t = 0;
+            if (length_squared > 0) {
+                t = Clamp01(((center_x - from.x) * dx + (center_y - from.y) * dy) / length_squared);
+            }
+            const double offset_x = center_x - from.x - dx * t;
+            const double offset_y = center_y - from.y - dy * t;
+            const double distance = std::sqrt(offset_x * offset_x + offset_y * offset_y);
+            Cover(static_cast<uint32_t>(x), static_cast<uint32_t>(y), Clamp01(reach - distance) * weight);
+        }
+    }
+}
+
+void Painter::CoverRing(svg::Point center, double radius, double half_width) {
+    const double reach = radius + half_width + 0.5;
+    const double weight = std::min(1.0, 2 * half_width);
+    const double top = std::max<double>(row_begin_, std::floor(center.y - reach));
+    const double bottom = std::min<double>(row_end_, std::ceil(center.y + reach));
+    const double left = std::max(0.0, std::floor(center.x - reach));
+    const double right = std::min<double>(canvas_.width_, std::ceil(center.x + reach));
+    for (double y = top; y < bottom; ++y) {
+        for (double x = left; x < right; ++x) {
+            const double offset_x = x + 0.5 - center.x;
+            const double offset_y = y + 0.5 - center.y;
+            const double distance = std::sqrt(offset_x * offset_x + offset_y * offset_y);
+            Cover(static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+                  Clamp01(half_width + 0.5 - std::abs(distance - radius)) * weight);
+        }
+    }
+}
+
+void Painter::CoverRect(double left, double top, double right, double bottom, double radius) {
+    const double reach = radius + 0.5;
+    const double row_top = std::max<double>(row_begin_, std::floor(top - reach));
+    const double row_bottom = std::min<double>(row_end_, std::ceil(bottom + reach));
+    const double column_left = std::max(0.0, std::floor(left - reach));
+    const double column_right = std::min<double>(canvas_.width_, std::ceil(right + reach));
+    for (double y = row_top; y < row_bottom; ++y) {
+        const double center_y = y + 0.5;
+        for (double x = column_left; x < column_right; ++x) {
+            const double center_x = x + 0.5;
+            // Расстояние со знаком: внутри прямоугольника отрицательное
+            const double outside_x = std::max({left - center_x, 0.0, center_x - right});
+            const double outside_y = std::max({top - center_y, 0.0, center_y - bottom});
+            const double distance = outside_x > 0 || outside_y > 0
+                ? std::sqrt(outside_x * outside_x + outside_y * outside_y)
+                : -std::min({center_x - left, right - center_x, center_y - top, bottom - center_y});
+            Cover(static_cast<uint32_t>(x), static_cast<uint32_t>(y), Clamp01(reach - distance));
+        }
+    }
+}
+
+void Painter::CoverText(const svg::Text& text, double radius) {
+    const double cell = text.GetFontSize() / FONT_SIZE_CELLS;
+    // Полужирные буквы рисуются с утолщёнными вертикальными штрихами
+    const double bold = text.GetFontWeight() == "bold" ? cell / 2 : 0;
+    double x = text.GetPosition().x + text.GetOffset().x;
+    const double baseline = text.GetPosition().y + text.GetOffset().y;
+    const double top = baseline - GLYPH_HEIGHT * cell;
+    if (baseline + radius + 1 < row_begin_ || top - radius - 1 > row_end_) {
+        return;
+    }
+    const std::string& data = text.GetData();
+    for (size_t pos = 0; pos < data.size(); x += GLYPH_ADVANCE * cell) {
+        const uint8_t* glyph = FindGlyph(DecodeUtf8(data, pos));
+        for (int column = 0; column < GLYPH_WIDTH; ++column) {
+            // Соседние точки столбца объединяются в один вертикальный штрих
+            for (int row = 0; row < GLYPH_HEIGHT;) {
+                if (!(glyph[column] >> row & 1)) {
+                    ++row;
+                    continue;
+                }
+                const int run_begin = row;
+                while (row < GLYPH_HEIGHT && (glyph[column] >> row & 1)) {
+                    ++row;
+                }
+                CoverRect(x + column * cell, top + run_begin * cell, x + (column + 1) * cell + bold,
+                          top + row * cell, radius);
+            }
+        }
+    }
+}
+
+void Painter::Fill(const Color& color) {
+    // Обычное наложение "поверх" для цветов без предумножения на прозрачность
+    const size_t band_offset = size_t{row_begin_} * canvas_.width_;
+    const float channels[3] = {static_cast<float>(color.red * 255), static_cast<float>(color.green * 255),
+                               static_cast<float>(color.blue * 255)};
+    const uint8_t opaque[4] = {static_cast<uint8_t>(std::lround(channels[0])),
+                               static_cast<uint8_t>(std::lround(channels[1])),
+                               static_cast<uint8_t>(std::lround(channels[2])), 255};
+    for (const uint32_t index : covered_) {
+        const float alpha = static_cast<float>(color.alpha) * mask_[index];
+        mask_[index] = 0;
+        uint8_t* pixel = canvas_.pixels_.data() + (band_offset + index) * 4;
+        if (alpha >= 1) {
+            std::copy(opaque, opaque + 4, pixel);
+            continue;
+        }
+        const float under_alpha = pixel[3] / 255.0f * (1 - alpha);
+        const float result_alpha = alpha + under_alpha;
+        if (result_alpha <= 0) {
+            continue;
+        }
+        for (int channel = 0; channel < 3; ++channel) {
+            const float value = (channels[channel] * alpha + pixel[channel] * under_alpha) / result_alpha;
+            pixel[channel] = static_cast<uint8_t>(value + 0.5f);
+        }
+        pixel[3] = static_cast<uint8_t>(result_alpha * 255 + 0.5f);
+    }
+    covered_.clear();
+}
+
+bool Painter::GetColor(const std::optional<svg::Color>& color, const Color& default_color, Color& result) {
+    if (!color) {
+        result = default_color;
+        return result.alpha > 0;
+    }
+    auto from_rgb = [](uint32_t red, uint32_t green, uint32_t blue, double alpha) {
+        return Color{red / 255.0, green / 255.0, blue / 255.0, Clamp01(alpha)};
+    };
+    if (const auto* rgba = std::get_if<svg::Rgba>(&*color)) {
+        result = from_rgb(rgba->red, rgba->green, rgba->blue, rgba->opacity);
+    } else if (const auto* rgb = std::get_if<svg::Rgb>(&*color)) {
+        result = from_rgb(rgb->red, rgb->green, rgb->blue, 1);
+    } else if (const auto* name = std::get_if<std::string>(&*color); name && *name != "none") {
+        const uint32_t value = ParseColorName(*name);
+        result = from_rgb(value >> 16, value >> 8 & 0xFF, value & 0xFF, 1);
+    } else {
+        return false;
+    }
+    return result.alpha > 0;
+}
+
+}  // namespace raster
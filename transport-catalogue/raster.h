@@ -0,0 +1,69 @@
+#pragma once
+
+#include "svg.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace raster {
+
+// Растровое изображение RGBA, 8 бит на канал. Изначально все пиксели прозрачные, как фон SVG
+class Canvas {
+public:
+    Canvas(uint32_t width, uint32_t height);
+
+    uint32_t GetWidth() const;
+    uint32_t GetHeight() const;
+    // Строки сверху вниз, по четыре байта на пиксель
+    const std::vector<uint8_t>& GetPixels() const;
+
+private:
+    friend class Painter;
+
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    std::vector<uint8_t> pixels_;
+};
+
+// Рисует объекты svg на холсте со сглаживанием, как их нарисовал бы просмотрщик SVG:
+// сначала заливка, затем обводка, концы и стыки линий скруглены.
+// Текст выводится встроенным растровым шрифтом 5x7 с латиницей и кириллицей.
+// Painter меняет только строки [row_begin, row_end), поэтому полосы одного холста
+// можно рисовать в разных потоках, и результат не зависит от разбиения на полосы
+class Painter {
+public:
+    Painter(Canvas& canvas, uint32_t row_begin, uint32_t row_end);
+
+    void Draw(const svg::Polyline& polyline);
+    void Draw(const svg::Circle& circle);
+    void Draw(const svg::Text& text);
+
+private:
+    struct Color {
+        double red = 0;
+        double green = 0;
+        double blue = 0;
+        double alpha = 0;
+    };
+
+    // Покрытие пикселей фигурой накапливается в маске как максимум по её частям,
+    // поэтому стыки отрезков и соседние клетки букв не закрашиваются дважды
+    void Cover(uint32_t x, uint32_t y, double coverage);
+    void CoverSegment(svg::Point from, svg::Point to, double radius);
+    void CoverRing(svg::Point center, double radius, double half_width);
+    // Прямоугольник, расширенный на radius со скруглёнными углами
+    void CoverRect(double left, double top, double right, double bottom, double radius);
+    void CoverText(const svg::Text& text, double radius);
+    // Смешивает цвет с холстом по маске и очищает маску
+    void Fill(const Color& color);
+
+    static bool GetColor(const std::optional<svg::Color>& color, const Color& default_color, Color& result);
+
+    Canvas& canvas_;
+    uint32_t row_begin_ = 0;
+    uint32_t row_end_ = 0;
+    std::vector<float> mask_;
+    std::vector<uint32_t> covered_;
+};
+
+}  // namespace raster
@@ -1,5 +1,7 @@
 #include "request_handler.h"
 
+#include <algorithm>
+
 std::optional<tc::RouteInformation> RequestHandler::GetBusStat(std::string_view bus_name) const{
     return db_.GetBusStat(bus_name);
 }
@@ -20,10 +22,86 @@ svg::Document RequestHandler::RenderMap() const{
     return renderer_.RenderMap(db_);
 }
 
+void RequestHandler::RenderMap(std::ostream& out) const{
+    renderer_.RenderMap(db_, out);
+}
+
+void RequestHandler::RenderMapPng(std::ostream& out) const{
+    renderer_.RenderMapPng(db_, out);
+}
+
+render::MapFormat RequestHandler::GetMapFormat() const{
+    return renderer_.GetRenderSettings().format;
+}
+
+svg::Document RequestHandler::RenderStopsOverlay(const std::vector<std::string_view>& stop_names) const{
+    return renderer_.RenderStopsOverlay(db_, stop_names);
+}
+
+const tc::Stop* RequestHandler::FindNearestStop(geo::Coordinates cords) const{
+    return db_.FindNearestStop(cords);
+}
+
 const std::optional<std::vector<tc::RouterEdge>> RequestHandler::GetRoute(const std::string& start, const std::string& end) const{
     return router_.BuildRoute(start, end);
 }
 
+const std::optional<std::vector<tc::RouterEdge>> RequestHandler::GetRoute(const std::string& start, const std::string& end, double departure_time) const{
+    return router_.BuildRoute(start, end, departure_time);
+}
+
+std::vector<tc::RouteOption> RequestHandler::GetParetoRoutes(const std::string& start, const std::string& end) const{
+    return router_.BuildParetoRoutes(start, end);
+}
+
+std::vector<tc::RouteOption> RequestHandler::GetAlternativeRoutes(const std::string& start, const std::string& end,
+                                                                  size_t max_count) const{
+    return router_.BuildAlternativeRoutes(start, end, max_count);
+}
+
+size_t RequestHandler::SelectPreferredOption(const std::vector<tc::RouteOption>& options) const{
+    return router_.SelectPreferredOption(options);
+}
+
+std::vector<std::optional<std::vector<tc::RouterEdge>>> RequestHandler::GetRoutes(const std::string& start, const std::vector<std::string>& ends) const{
+    return router_.BuildRoutes(start, ends);
+}
+
+std::vector<tc::ReachableStop> RequestHandler::GetReachableStops(const std::string& start, double max_time) const{
+    return router_.GetReachableStops(start, max_time);
+}
+
+tc::TravelTimeMatrix RequestHandler::GetTravelTimes(const std::vector<std::string>& starts, const std::vector<std::string>& ends,
+                                                    bool with_transfers) const{
+    return router_.GetTravelTimes(starts, ends, with_transfers);
+}
+
 int RequestHandler::GetBusWaitTime() const{
     return router_.GetRouterSettings().bus_wait_time;
-}
\ No newline at end of file
+}
+
+graph::RouteTreeCacheStats RequestHandler::GetRouteCacheStats() const{
+    return router_.GetRouteCacheStats();
+}
+
+std::vector<std::string_view> RequestHandler::GetStopNamesById() const{
+    std::vector<std::string_view> names;
+    names.reserve(db_.GetStopCount());
+    for(uint32_t id = 0; id < db_.GetStopCount(); ++id){
+        names.push_back(db_.GetStopById(id)->stop_name);
+    }
+    return names;
+}
+
+std::vector<std::string_view> RequestHandler::GetSortedBusNames() const{
+    std::vector<std::string_view> names;
+    for(const auto& [bus_name, bus] : db_.GetBusesMap()){
+        names.push_back(bus_name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+uint64_t RequestHandler::GetCatalogueVersion() const{
+    return db_.GetVersion();
+}
@@ -21,9 +21,31 @@ public:
     std::vector<svg::Circle> GetStopCircles(const render::SphereProjector& projector) const;
     std::vector<svg::Text> GetStopNames(const render::SphereProjector& projector) const;
     svg::Document RenderMap() const;
+    // Выводит карту в out потоком, не собирая svg::Document
+    void RenderMap(std::ostream& out) const;
+    // Выводит карту изображением PNG
+    void RenderMapPng(std::ostream& out) const;
+    render::MapFormat GetMapFormat() const;
+    svg::Document RenderStopsOverlay(const std::vector<std::string_view>& stop_names) const;
+    const tc::Stop* FindNearestStop(geo::Coordinates cords) const;
 
     const std::optional<std::vector<tc::RouterEdge>> GetRoute(const std::string& start, const std::string& end) const;
+    const std::optional<std::vector<tc::RouterEdge>> GetRoute(const std::string& start, const std::string& end, double departure_time) const;
+    std::vector<tc::RouteOption> GetParetoRoutes(const std::string& start, const std::string& end) const;
+    std::vector<tc::RouteOption> GetAlternativeRoutes(const std::string& start, const std::string& end, size_t max_count) const;
+    size_t SelectPreferredOption(const std::vector<tc::RouteOption>& options) const;
+    std::vector<std::optional<std::vector<tc::RouterEdge>>> GetRoutes(const std::string& start, const std::vector<std::string>& ends) const;
+    std::vector<tc::ReachableStop> GetReachableStops(const std::string& start, double max_time) const;
+    tc::TravelTimeMatrix GetTravelTimes(const std::vector<std::string>& starts, const std::vector<std::string>& ends,
+                                        bool with_transfers) const;
     int GetBusWaitTime() const;
+    // Статистика кэша деревьев маршрутов, нулевая, если маршрутизатор построен с таблицей всех пар
+    graph::RouteTreeCacheStats GetRouteCacheStats() const;
+    // Имена всех остановок по их номерам в справочнике
+    std::vector<std::string_view> GetStopNamesById() const;
+    // Имена всех маршрутов в порядке возрастания
+    std::vector<std::string_view> GetSortedBusNames() const;
+    uint64_t GetCatalogueVersion() const;
 
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
@@ -0,0 +1,103 @@
+#include "response_cache.h"
+#include "metrics.h"
+
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+CachedResponse::CachedResponse(std::string text, int indent)
+    : text_(std::move(text)){
+    // Ключи словаря ответа печатаются с новой строки на следующем уровне отступа.
+    // Внутри строковых значений перевод строки экранирован, поэтому совпадение
+    // возможно только с ключом самого ответа
+    const std::string id_key = "\n" + std::string(indent + 4, ' ') + "\"request_id\": ";
+    const size_t key_pos = text_.find(id_key);
+    if(key_pos == std::string::npos){
+        throw std::logic_error("Response has no request_id");
+    }
+    id_pos_ = key_pos + id_key.size();
+    id_size_ = text_.find_first_of(",\n", id_pos_) - id_pos_;
+}
+
+void CachedResponse::Print(std::ostream& out, int request_id) const {
+    std::array<char, 16> buffer;
+    const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), request_id);
+    out.write(text_.data(), id_pos_);
+    out.write(buffer.data(), ptr - buffer.data());
+    out.write(text_.data() + id_pos_ + id_size_, text_.size() - id_pos_ - id_size_);
+}
+
+size_t CachedResponse::GetSize() const {
+    return text_.size();
+}
+
+ResponseCache::ResponseCache(size_t memory_limit_bytes)
+    : memory_limit_bytes_(memory_limit_bytes){
+}
+
+std::string ResponseCache::MakeKey(std::string_view type, std::initializer_list<std::string_view> args){
+    std::string key(type);
+    for(const std::string_view arg : args){
+        key.push_back('\0');
+        key.append(arg);
+    }
+    return key;
+}
+
+void ResponseCache::SetVersion(uint64_t version){
+    if(version == version_){
+        return;
+    }
+    version_ = version;
+    if(!lru_.empty()){
+        Clear();
+        ++stats_.invalidations;
+    }
+}
+
+ResponseCache::ResponsePtr ResponseCache::Find(const std::string& key){
+    const auto it = entries_.find(key);
+    if(it == entries_.end()){
+        ++stats_.misses;
+        TC_METRICS_COUNT("response_cache_misses", 1);
+        return nullptr;
+    }
+    ++stats_.hits;
+    TC_METRICS_COUNT("response_cache_hits", 1);
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->response;
+}
+
+void ResponseCache::Insert(std::string key, ResponsePtr response){
+    Entry entry{std::move(key), std::move(response)};
+    const size_t entry_size = GetEntrySize(entry);
+    if(entry_size > memory_limit_bytes_ || entries_.count(entry.key)){
+        return;
+    }
+    while(!lru_.empty() && stats_.bytes + entry_size > memory_limit_bytes_){
+        stats_.bytes -= GetEntrySize(lru_.back());
+        entries_.erase(lru_.back().key);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+    lru_.push_front(std::move(entry));
+    // Ключ словаря ссылается на строку в элементе списка, которая не перемещается
+    entries_.emplace(lru_.front().key, lru_.begin());
+    stats_.bytes += entry_size;
+}
+
+ResponseCacheStats ResponseCache::GetStats() const {
+    return stats_;
+}
+
+size_t ResponseCache::GetEntrySize(const Entry& entry){
+    // Кроме текстов учитываются узел списка, элемент словаря и сам ответ
+    constexpr size_t ENTRY_OVERHEAD = 128;
+    return entry.key.size() + entry.response->GetSize() + ENTRY_OVERHEAD;
+}
+
+void ResponseCache::Clear(){
+    entries_.clear();
+    lru_.clear();
+    stats_.bytes = 0;
+}
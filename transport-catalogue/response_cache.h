@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Напечатанный ответ на запрос без значения request_id. Номер запроса
+// подставляется при выводе, поэтому один ответ обслуживает все повторы запроса
+class CachedResponse {
+public:
+    // text - словарь ответа, напечатанный json::Print с отступом indent, с номером request_id
+    CachedResponse(std::string text, int indent);
+
+    void Print(std::ostream& out, int request_id) const;
+    size_t GetSize() const;
+
+private:
+    std::string text_;
+    // Положение и длина значения request_id в text_
+    size_t id_pos_ = 0;
+    size_t id_size_ = 0;
+};
+
+struct ResponseCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    // Сколько раз кэш сбрасывался из-за изменения справочника
+    uint64_t invalidations = 0;
+    size_t bytes = 0;
+};
+
+// LRU-кэш ответов на запросы по ключу из типа запроса и его аргументов.
+// Объём ответов ограничен memory_limit_bytes. Кэш не потокобезопасен
+class ResponseCache {
+public:
+    using ResponsePtr = std::shared_ptr<const CachedResponse>;
+
+    explicit ResponseCache(size_t memory_limit_bytes);
+
+    // Ключ из типа запроса и его аргументов. Аргументы разделяются нулевым символом,
+    // которого нет в именах, поэтому разные наборы аргументов не дают одинаковых ключей
+    static std::string MakeKey(std::string_view type, std::initializer_list<std::string_view> args);
+
+    // Сбрасывает кэш, если версия справочника отличается от той, для которой он заполнялся
+    void SetVersion(uint64_t version);
+    // Ответ или nullptr. Найденный ответ становится самым недавно использованным
+    ResponsePtr Find(const std::string& key);
+    // Вытесняет давно использованные ответы, пока их объём не уложится в ограничение.
+    // Ответ, больший ограничения, не сохраняется
+    void Insert(std::string key, ResponsePtr response);
+    ResponseCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        ResponsePtr response;
+    };
+    using LruList = std::list<Entry>;
+
+    static size_t GetEntrySize(const Entry& entry);
+    void Clear();
+
+    size_t memory_limit_bytes_ = 0;
+    uint64_t version_ = 0;
+    LruList lru_;
+    std::unordered_map<std::string_view, LruList::iterator> entries_;
+    ResponseCacheStats stats_;
+};
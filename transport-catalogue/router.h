@@ -1,19 +1,65 @@
 #pragma once
 
 #include "graph.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace graph {
 
+namespace detail {
+
+// Релаксация строки таблицы через вершину для весов с бесконечностью: недостижимым ячейкам
+// соответствует бесконечный вес, поэтому проверка сводится к одному сравнению min-plus.
+// Для улучшенных ячеек вызывается on_improved(to), веса в row_weights обновляются здесь.
+// Сравнение и сложение те же, что в скалярном цикле, так что результат не зависит от AVX2
+template <typename Weight, typename OnImproved>
+void RelaxRow(Weight weight_from, const Weight* through_weights, Weight* row_weights, size_t count,
+              OnImproved on_improved) {
+    size_t to = 0;
+#ifdef __AVX2__
+    if constexpr (std::is_same_v<Weight, double>) {
+        const __m256d from = _mm256_set1_pd(weight_from);
+        for (; to + 4 <= count; to += 4) {
+            const __m256d candidate = _mm256_add_pd(from, _mm256_loadu_pd(through_weights + to));
+            const __m256d current = _mm256_loadu_pd(row_weights + to);
+            const __m256d less = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+            int mask = _mm256_movemask_pd(less);
+            if (mask == 0) {
+                continue;
+            }
+            _mm256_storeu_pd(row_weights + to, _mm256_blendv_pd(current, candidate, less));
+            for (; mask != 0; mask &= mask - 1) {
+                on_improved(to + __builtin_ctz(mask));
+            }
+        }
+    }
+#endif
+    for (; to < count; ++to) {
+        const Weight candidate = weight_from + through_weights[to];
+        if (candidate < row_weights[to]) {
+            row_weights[to] = candidate;
+            on_improved(to);
+        }
+    }
+}
+
+}  // namespace detail
+
 template <typename Weight>
 class Router {
 private:
@@ -27,49 +73,91 @@ public:
         std::vector<EdgeId> edges;
     };
 
+    // Вес маршрута и число рёбер в нём, без восстановления самих рёбер
+    struct RouteSummary {
+        Weight weight;
+        size_t edge_count = 0;
+    };
+
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Маршруты из одной вершины во все вершины targets. Строка таблицы для from является
+    // деревом кратчайших путей, поэтому все цели восстанавливаются из неё за один заход
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+
+    std::optional<RouteSummary> GetRouteSummary(VertexId from, VertexId to) const;
+    // Сводки маршрутов из одной вершины во все вершины targets, в том же порядке
+    std::vector<std::optional<RouteSummary>> GetRouteSummaries(VertexId from, const std::vector<VertexId>& targets) const;
+
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // Таблица маршрутов хранится двумя плоскими массивами V x V: веса и последние рёбра маршрутов.
+    // Вместо std::optional используются 32-битные идентификаторы рёбер с особыми значениями
+    static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+    static constexpr uint32_t ROUTE_START = UINT32_MAX - 1;
+    // Если у веса есть бесконечность, ею заполняются недостижимые ячейки, и релаксация
+    // идёт без ветвлений по NO_ROUTE (см. detail::RelaxRow)
+    static constexpr bool HAS_INFINITY = std::numeric_limits<Weight>::has_infinity;
+    // Меньше строк на поток не имеет смысла: фазы разделены барьером
+    static constexpr size_t MIN_RELAX_ROWS = 64;
+
+    size_t GetCell(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
+
+    std::optional<RouteInfo> BuildRouteFromTree(VertexId from, VertexId to) const;
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        if (graph.GetEdgeCount() >= ROUTE_START) {
+            throw std::length_error("Too many edges for the route table");
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            const size_t cell = GetCell(vertex, vertex);
+            weights_[cell] = ZERO_WEIGHT;
+            prev_edges_[cell] = ROUTE_START;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t edge_cell = GetCell(vertex, edge.to);
+                if (prev_edges_[edge_cell] == NO_ROUTE || !(weights_[edge_cell] < edge.weight)) {
+                    weights_[edge_cell] = edge.weight;
+                    prev_edges_[edge_cell] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
-
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    // Релаксирует строки [rows_begin, rows_end) через vertex_through. Строка vertex_through
+    // на этой фазе не меняется, поэтому разные строки можно обрабатывать параллельно
+    void RelaxRowsThroughVertex(VertexId rows_begin, VertexId rows_end, VertexId vertex_through) {
+        const Weight* through_weights = &weights_[GetCell(vertex_through, 0)];
+        const uint32_t* through_prev_edges = &prev_edges_[GetCell(vertex_through, 0)];
+        for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+            const size_t cell_from = GetCell(vertex_from, vertex_through);
+            if (prev_edges_[cell_from] == NO_ROUTE) {
+                continue;
+            }
+            const Weight weight_from = weights_[cell_from];
+            const uint32_t prev_edge_from = prev_edges_[cell_from];
+            Weight* row_weights = &weights_[GetCell(vertex_from, 0)];
+            uint32_t* row_prev_edges = &prev_edges_[GetCell(vertex_from, 0)];
+            if constexpr (HAS_INFINITY) {
+                detail::RelaxRow(weight_from, through_weights, row_weights, vertex_count_, [&](size_t vertex_to) {
+                    const uint32_t prev_edge_to = through_prev_edges[vertex_to];
+                    row_prev_edges[vertex_to] = prev_edge_to != ROUTE_START ? prev_edge_to : prev_edge_from;
+                });
+                continue;
+            }
+            for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                const uint32_t prev_edge_to = through_prev_edges[vertex_to];
+                if (prev_edge_to == NO_ROUTE) {
+                    continue;
+                }
+                const Weight candidate_weight = weight_from + through_weights[vertex_to];
+                if (row_prev_edges[vertex_to] == NO_ROUTE || candidate_weight < row_weights[vertex_to]) {
+                    row_weights[vertex_to] = candidate_weight;
+                    row_prev_edges[vertex_to] = prev_edge_to != ROUTE_START ? prev_edge_to : prev_edge_from;
                 }
             }
         }
@@ -77,41 +165,95 @@ private:
 
     Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_ = 0;
+    std::vector<Weight> weights_;
+    std::vector<uint32_t> prev_edges_;
 };
 
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
+    , weights_(vertex_count_ * vertex_count_, HAS_INFINITY ? std::numeric_limits<Weight>::infinity() : Weight{})
+    , prev_edges_(vertex_count_ * vertex_count_, NO_ROUTE)
 {
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
-    }
+    // Фазы по промежуточной вершине идут в прежнем порядке, внутри фазы строки делятся
+    // между потоками. Порядок сравнений для каждой ячейки тот же, что в последовательном
+    // алгоритме, поэтому и маршруты при равных весах выбираются те же
+    par::Barrier barrier(par::GetChunkCount(vertex_count_, MIN_RELAX_ROWS));
+    par::ForEachChunk(vertex_count_, MIN_RELAX_ROWS, [this, &barrier](size_t, size_t begin, size_t end) {
+        for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+            RelaxRowsThroughVertex(begin, end, vertex_through);
+            barrier.Wait();
+        }
+    });
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    return BuildRouteFromTree(from, to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename Router<Weight>::RouteInfo>>
+Router<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const {
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        routes.push_back(BuildRouteFromTree(from, to));
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteSummary> Router<Weight>::GetRouteSummary(VertexId from,
+                                                                                   VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const uint32_t* tree = &prev_edges_[GetCell(from, 0)];
+    if (tree[to] == NO_ROUTE) {
+        return std::nullopt;
+    }
+    size_t edge_count = 0;
+    for (uint32_t edge_id = tree[to]; edge_id != ROUTE_START; edge_id = tree[graph_.GetEdge(edge_id).from]) {
+        ++edge_count;
+    }
+    return RouteSummary{weights_[GetCell(from, to)], edge_count};
+}
+
+template <typename Weight>
+std::vector<std::optional<typename Router<Weight>::RouteSummary>>
+Router<Weight>::GetRouteSummaries(VertexId from, const std::vector<VertexId>& targets) const {
+    std::vector<std::optional<RouteSummary>> summaries;
+    summaries.reserve(targets.size());
+    for (const VertexId to : targets) {
+        summaries.push_back(GetRouteSummary(from, to));
+    }
+    return summaries;
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo>
+Router<Weight>::BuildRouteFromTree(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    // Строка таблицы для from является деревом кратчайших путей из from
+    const uint32_t* tree = &prev_edges_[GetCell(from, 0)];
+    if (tree[to] == NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-    {
-        edges.push_back(*edge_id);
+    for (uint32_t edge_id = tree[to]; edge_id != ROUTE_START; edge_id = tree[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    return RouteInfo{weights_[GetCell(from, to)], std::move(edges)};
 }
 
 }  // namespace graph
\ No newline at end of file
@@ -45,7 +45,8 @@ void Object::Render(const RenderContext& context) const {
 
     RenderObject(context);
 
-    context.out << std::endl;
+    // Без сброса буфера на каждом объекте: большие карты выводятся потоком
+    context.out.put('\n');
 }
 
 // ---------- Circle ------------------
@@ -60,6 +61,14 @@ Circle& Circle::SetRadius(double radius)  {
     return *this;
 }
 
+Point Circle::GetCenter() const {
+    return center_;
+}
+
+double Circle::GetRadius() const {
+    return radius_;
+}
+
 void Circle::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
@@ -75,6 +84,10 @@ Polyline& Polyline::AddPoint(Point point){
     return *this;
 }
 
+const std::vector<Point>& Polyline::GetPoints() const {
+    return points_;
+}
+
 void Polyline::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<polyline points=\""sv;
@@ -126,6 +139,26 @@ Text& Text::SetData(std::string data){
     return *this;
 }
 
+Point Text::GetPosition() const {
+    return pos_;
+}
+
+Point Text::GetOffset() const {
+    return offset_;
+}
+
+uint32_t Text::GetFontSize() const {
+    return size_;
+}
+
+const std::string& Text::GetFontWeight() const {
+    return font_weight_;
+}
+
+const std::string& Text::GetData() const {
+    return data_;
+}
+
 std::string Text::ParseData(const std::string& data) const {
     std::string result;
     for (char ch : data){
@@ -174,14 +207,48 @@ void Document::AddPtr(std::unique_ptr<Object>&& obj){
     objects_.emplace_back(std::move(obj));
 }
 
-void Document::Render(std::ostream& out) const {
-    RenderContext render_context{out, 2, 2};
+namespace {
+
+void RenderHeader(std::ostream& out){
     out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv
         << "\n<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n";
+}
+
+void RenderFooter(std::ostream& out){
+    out << "</svg>"sv;
+}
+
+}  // namespace
+
+void Document::Render(std::ostream& out) const {
+    RenderContext render_context{out, 2, 2};
+    RenderHeader(out);
     for (const auto& object : objects_){
         object->Render(render_context);
     }
-    out << "</svg>"sv;
+    RenderFooter(out);
+}
+
+// ---------- StreamDocument ------------------
+
+StreamDocument::StreamDocument(std::ostream& out)
+    : out_(out){
+    RenderHeader(out_);
+}
+
+StreamDocument::~StreamDocument(){
+    Close();
+}
+
+void StreamDocument::AddPtr(std::unique_ptr<Object>&& obj){
+    obj->Render(RenderContext{out_, 2, 2});
+}
+
+void StreamDocument::Close(){
+    if (!closed_){
+        RenderFooter(out_);
+        closed_ = true;
+    }
 }
 // ---------- Colors ------------------
 
@@ -134,6 +134,18 @@ public:
         return AsOwner();
     }
 
+    const std::optional<Color>& GetFillColor() const {
+        return fill_color_;
+    }
+
+    const std::optional<Color>& GetStrokeColor() const {
+        return stroke_color_;
+    }
+
+    std::optional<double> GetStrokeWidth() const {
+        return width_;
+    }
+
 protected:
     ~PathProps() = default;
 
@@ -162,6 +174,8 @@ class Circle final : public Object, public PathProps<Circle> {
 public:
     Circle& SetCenter(Point center);
     Circle& SetRadius(double radius);
+    Point GetCenter() const;
+    double GetRadius() const;
 
 private:
     void RenderObject(const RenderContext& context) const override;
@@ -173,6 +187,7 @@ private:
 class Polyline final : public Object, public PathProps<Polyline> {
 public:
     Polyline& AddPoint(Point point);
+    const std::vector<Point>& GetPoints() const;
 
 private:
     void RenderObject(const RenderContext& context) const override;
@@ -194,6 +209,12 @@ public:
 
     Text& SetData(std::string data);
 
+    Point GetPosition() const;
+    Point GetOffset() const;
+    uint32_t GetFontSize() const;
+    const std::string& GetFontWeight() const;
+    const std::string& GetData() const;
+
 private:
     void RenderObject(const RenderContext& context) const override;
     std::string ParseData(const std::string& data) const;
@@ -234,4 +255,27 @@ private:
     std::vector<std::unique_ptr<Object>> objects_;
 };
 
+// Документ, который не хранит объекты: каждый добавленный объект сразу выводится в out
+// и уничтожается. Результат совпадает с Document::Render для тех же объектов.
+// Заголовок выводится при создании, закрывающий тег - в Close или в деструкторе
+class StreamDocument : public ObjectContainer {
+public:
+    explicit StreamDocument(std::ostream& out);
+    StreamDocument(const StreamDocument&) = delete;
+    StreamDocument& operator=(const StreamDocument&) = delete;
+    ~StreamDocument() override;
+
+    // Выводит объект без копирования в кучу
+    template <typename Obj>
+    void Add(const Obj& obj) {
+        obj.Render(RenderContext{out_, 2, 2});
+    }
+    void AddPtr(std::unique_ptr<Object>&& obj) override;
+    void Close();
+
+private:
+    std::ostream& out_;
+    bool closed_ = false;
+};
+
 }  // namespace svg
\ No newline at end of file
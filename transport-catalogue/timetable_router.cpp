@@ -0,0 +1,243 @@
+#include "timetable_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace tc {
+
+namespace {
+constexpr double INF = std::numeric_limits<double>::infinity();
+}
+
+TimetableRouter::TimetableRouter(const TransportCatalogue& catalogue, double bus_velocity, size_t max_rides)
+                                : max_rides_(max_rides){
+    std::vector<const Bus*> buses;
+    for (const auto& [bus_name, bus] : catalogue.GetBusesMap()){
+        if (bus->stop_count > 1 && !catalogue.GetBusDepartures(bus).empty()){
+            buses.push_back(bus);
+        }
+    }
+    std::sort(buses.begin(), buses.end(), [](const Bus* lhs, const Bus* rhs){
+        return lhs->bus_name < rhs->bus_name;
+    });
+
+    for (const Bus* bus : buses){
+        std::vector<const Stop*> stops;
+        for (const uint32_t stop_id : catalogue.GetBusStopIds(*bus)){
+            stops.push_back(catalogue.GetStopById(stop_id));
+        }
+        if (!bus->is_roundtrip){
+            stops.insert(stops.end(), std::next(stops.rbegin()), stops.rend());
+        }
+
+        const std::vector<double>& departures = catalogue.GetBusDepartures(bus);
+        RouteData route;
+        route.bus_name = bus->bus_name;
+        route.stops_begin = static_cast<uint32_t>(route_stops_.size());
+        route.stops_count = static_cast<uint32_t>(stops.size());
+        route.trips_begin = static_cast<uint32_t>(route_trips_.size());
+        route.trips_count = static_cast<uint32_t>(departures.size());
+        double offset = 0;
+        for (size_t i = 0; i < stops.size(); ++i){
+            if (i > 0){
+                offset += catalogue.GetDistanceBetweenStops(stops[i - 1], stops[i]) / bus_velocity;
+            }
+            route_stops_.push_back(GetStopIndex(stops[i]->stop_name));
+            route_offsets_.push_back(offset);
+        }
+        route_trips_.insert(route_trips_.end(), departures.begin(), departures.end());
+        routes_.push_back(route);
+    }
+
+    stop_routes_begin_.assign(stop_names_.size() + 1, 0);
+    for (const uint32_t stop : route_stops_){
+        ++stop_routes_begin_[stop + 1];
+    }
+    for (size_t i = 1; i < stop_routes_begin_.size(); ++i){
+        stop_routes_begin_[i] += stop_routes_begin_[i - 1];
+    }
+    stop_routes_.resize(route_stops_.size());
+    std::vector<uint32_t> filled(stop_routes_begin_.begin(), std::prev(stop_routes_begin_.end()));
+    for (uint32_t route = 0; route < routes_.size(); ++route){
+        for (uint32_t position = 0; position < routes_[route].stops_count; ++position){
+            const uint32_t stop = route_stops_[routes_[route].stops_begin + position];
+            stop_routes_[filled[stop]++] = {route, position};
+        }
+    }
+}
+
+bool TimetableRouter::HasSchedules() const {
+    return !routes_.empty();
+}
+
+uint32_t TimetableRouter::GetStopIndex(std::string_view stop_name){
+    auto [it, inserted] = stop_indexes_.emplace(stop_name, static_cast<uint32_t>(stop_names_.size()));
+    if (inserted){
+        stop_names_.push_back(stop_name);
+    }
+    return it->second;
+}
+
+double TimetableRouter::GetTripTime(const RouteData& route, uint32_t trip, uint32_t position) const {
+    return route_trips_[route.trips_begin + trip] + route_offsets_[route.stops_begin + position];
+}
+
+void TimetableRouter::ResetScratch(Scratch& scratch) const {
+    const size_t stop_count = stop_names_.size();
+    for (const uint32_t stop : scratch.touched){
+        for (size_t k = 0; k <= max_rides_; ++k){
+            scratch.arrivals[k * stop_count + stop] = INF;
+            scratch.labels[k * stop_count + stop] = Label{};
+        }
+        scratch.best[stop] = INF;
+    }
+    for (const uint32_t stop : scratch.marked){
+        scratch.is_marked[stop] = false;
+    }
+    scratch.touched.clear();
+    scratch.marked.clear();
+}
+
+std::optional<std::vector<TimetableLeg>>
+TimetableRouter::BuildRoute(std::string_view start, std::string_view end, double departure_time) const {
+    if (start == end){
+        return std::vector<TimetableLeg>{};
+    }
+    const auto start_it = stop_indexes_.find(start);
+    const auto end_it = stop_indexes_.find(end);
+    if (start_it == stop_indexes_.end() || end_it == stop_indexes_.end()){
+        return std::nullopt;
+    }
+    const uint32_t source = start_it->second;
+    const uint32_t target = end_it->second;
+    const size_t stop_count = stop_names_.size();
+
+    std::lock_guard lock(scratch_->mutex);
+    Scratch& scratch = *scratch_;
+    if (scratch.best.size() != stop_count){
+        scratch.arrivals.assign((max_rides_ + 1) * stop_count, INF);
+        scratch.labels.assign((max_rides_ + 1) * stop_count, Label{});
+        scratch.best.assign(stop_count, INF);
+        scratch.is_marked.assign(stop_count, false);
+        scratch.route_start.assign(routes_.size(), NONE);
+        scratch.touched.clear();
+        scratch.marked.clear();
+    }
+    else{
+        ResetScratch(scratch);
+    }
+    std::vector<double>& arrivals = scratch.arrivals;
+    std::vector<Label>& labels = scratch.labels;
+    std::vector<double>& best = scratch.best;
+    std::vector<bool>& is_marked = scratch.is_marked;
+    std::vector<uint32_t>& route_start = scratch.route_start;
+    std::vector<uint32_t>& touched = scratch.touched;
+    std::vector<uint32_t>& marked = scratch.marked;
+    std::vector<uint32_t>& queued_routes = scratch.queued_routes;
+    arrivals[source] = departure_time;
+    best[source] = departure_time;
+    touched.push_back(source);
+    marked.push_back(source);
+    is_marked[source] = true;
+
+    size_t rounds = 0;
+    for (size_t k = 1; k <= max_rides_ && !marked.empty(); ++k){
+        rounds = k;
+        const double* prev = &arrivals[(k - 1) * stop_count];
+        double* current = &arrivals[k * stop_count];
+        // У недостигнутых остановок время во всех раундах бесконечное, переносятся только достигнутые
+        for (const uint32_t stop : touched){
+            current[stop] = prev[stop];
+        }
+
+        // Каждый маршрут просматривается один раз, начиная с самой ранней отмеченной остановки
+        queued_routes.clear();
+        for (const uint32_t stop : marked){
+            is_marked[stop] = false;
+            for (uint32_t i = stop_routes_begin_[stop]; i < stop_routes_begin_[stop + 1]; ++i){
+                const auto [route, position] = stop_routes_[i];
+                if (route_start[route] == NONE){
+                    queued_routes.push_back(route);
+                    route_start[route] = position;
+                }
+                else{
+                    route_start[route] = std::min(route_start[route], position);
+                }
+            }
+        }
+        marked.clear();
+
+        for (const uint32_t route_index : queued_routes){
+            const RouteData& route = routes_[route_index];
+            uint32_t trip = NONE;
+            uint32_t board_position = NONE;
+            for (uint32_t position = route_start[route_index]; position < route.stops_count; ++position){
+                const uint32_t stop = route_stops_[route.stops_begin + position];
+                if (trip != NONE){
+                    const double arrival = GetTripTime(route, trip, position);
+                    if (arrival < best[stop] && arrival < best[target]){
+                        if (best[stop] == INF){
+                            touched.push_back(stop);
+                        }
+                        current[stop] = arrival;
+                        best[stop] = arrival;
+                        labels[k * stop_count + stop] = {route_index, trip, board_position, position};
+                        if (!is_marked[stop]){
+                            is_marked[stop] = true;
+                            marked.push_back(stop);
+                        }
+                    }
+                }
+                // Пересадка на более ранний рейс, если на остановку успели в прошлом раунде
+                if (prev[stop] < INF && (trip == NONE || prev[stop] <= GetTripTime(route, trip, position))){
+                    const auto trips_begin = route_trips_.begin() + route.trips_begin;
+                    const auto trips_end = trips_begin + route.trips_count;
+                    const auto it = std::lower_bound(trips_begin, trips_end,
+                                                     prev[stop] - route_offsets_[route.stops_begin + position]);
+                    const uint32_t earliest_trip = static_cast<uint32_t>(it - trips_begin);
+                    if (it != trips_end && (trip == NONE || earliest_trip < trip)){
+                        trip = earliest_trip;
+                        board_position = position;
+                    }
+                }
+            }
+            route_start[route_index] = NONE;
+        }
+    }
+
+    // Из раундов с одинаковым временем прибытия выбирается тот, где меньше рейсов
+    size_t best_round = 0;
+    for (size_t k = 1; k <= rounds; ++k){
+        if (arrivals[k * stop_count + target] < arrivals[best_round * stop_count + target]){
+            best_round = k;
+        }
+    }
+    if (arrivals[best_round * stop_count + target] == INF){
+        return std::nullopt;
+    }
+
+    std::vector<TimetableLeg> legs;
+    uint32_t stop = target;
+    for (size_t k = best_round; stop != source; --k){
+        while (labels[k * stop_count + stop].route == NONE){
+            --k;
+        }
+        const Label& label = labels[k * stop_count + stop];
+        const RouteData& route = routes_[label.route];
+        const uint32_t board_stop = route_stops_[route.stops_begin + label.board_position];
+        const double board_time = GetTripTime(route, label.trip, label.board_position);
+        TimetableLeg leg;
+        leg.bus = route.bus_name;
+        leg.start_stop = stop_names_[board_stop];
+        leg.dest_stop = stop_names_[stop];
+        leg.stop_count = static_cast<int>(label.alight_position - label.board_position);
+        leg.wait_time = board_time - arrivals[(k - 1) * stop_count + board_stop];
+        leg.ride_time = arrivals[k * stop_count + stop] - board_time;
+        legs.push_back(leg);
+        stop = board_stop;
+    }
+    std::reverse(legs.begin(), legs.end());
+    return legs;
+}
+
+}  // namespace tc
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tc {
+
+// Поездка на одном рейсе: ожидание на остановке посадки и время в пути до остановки высадки
+struct TimetableLeg{
+    std::string_view bus;
+    std::string_view start_stop;
+    std::string_view dest_stop;
+    int stop_count = 0;
+    double wait_time = 0;
+    double ride_time = 0;
+};
+
+// Поиск самого раннего прибытия по расписаниям маршрутов алгоритмом RAPTOR.
+// Каждый маршрут хранится как непрерывный массив остановок рейса со смещениями времени
+// прибытия от начала рейса, рейсы маршрута - отсортированный массив времени отправления.
+// Время в пути между остановками считается, как и в графе маршрутов, по расстоянию и скорости
+class TimetableRouter{
+public:
+    // Наибольшее число рейсов в маршруте поездки по умолчанию
+    static constexpr size_t DEFAULT_MAX_RIDES = 10;
+
+    TimetableRouter() = default;
+    // Маршруты, которым нужно больше max_rides рейсов, не находятся
+    TimetableRouter(const TransportCatalogue& catalogue, double bus_velocity,
+                    size_t max_rides = DEFAULT_MAX_RIDES);
+
+    bool HasSchedules() const;
+    // Поездки маршрута с самым ранним прибытием в end при отправлении из start
+    // не раньше departure_time (в минутах от начала суток)
+    std::optional<std::vector<TimetableLeg>>
+    BuildRoute(std::string_view start, std::string_view end, double departure_time) const;
+
+private:
+    // Маршрут, по которому ходят рейсы по расписанию. Для некольцевых маршрутов
+    // рейс проходит остановки туда и обратно
+    struct RouteData{
+        std::string_view bus_name;
+        uint32_t stops_begin = 0;
+        uint32_t stops_count = 0;
+        uint32_t trips_begin = 0;
+        uint32_t trips_count = 0;
+    };
+    // Позиция остановки в маршруте
+    struct StopRoute{
+        uint32_t route;
+        uint32_t position;
+    };
+    // Рейс, которым остановка достигнута в очередном раунде
+    struct Label{
+        uint32_t route = NONE;
+        uint32_t trip = NONE;
+        uint32_t board_position = NONE;
+        uint32_t alight_position = NONE;
+    };
+
+    // Рабочие массивы поиска, общие для всех запросов. Размеры задаются при первом запросе,
+    // после запроса сбрасываются только значения достигнутых остановок
+    struct Scratch{
+        std::mutex mutex;
+        // arrivals[k * stop_count + s] - самое раннее прибытие на s не более чем k рейсами
+        std::vector<double> arrivals;
+        std::vector<Label> labels;
+        std::vector<double> best;
+        std::vector<bool> is_marked;
+        std::vector<uint32_t> route_start;
+        // Остановки, значения которых изменил последний запрос
+        std::vector<uint32_t> touched;
+        std::vector<uint32_t> marked;
+        std::vector<uint32_t> queued_routes;
+    };
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t GetStopIndex(std::string_view stop_name);
+    double GetTripTime(const RouteData& route, uint32_t trip, uint32_t position) const;
+    void ResetScratch(Scratch& scratch) const;
+
+    std::vector<std::string_view> stop_names_;
+    std::unordered_map<std::string_view, uint32_t> stop_indexes_;
+    std::vector<RouteData> routes_;
+    std::vector<uint32_t> route_stops_;
+    std::vector<double> route_offsets_;
+    std::vector<double> route_trips_;
+    // Для остановки i её позиции в маршрутах лежат в stop_routes_[stop_routes_begin_[i], stop_routes_begin_[i + 1])
+    std::vector<uint32_t> stop_routes_begin_;
+    std::vector<StopRoute> stop_routes_;
+    size_t max_rides_ = DEFAULT_MAX_RIDES;
+    std::unique_ptr<Scratch> scratch_ = std::make_unique<Scratch>();
+};
+
+}  // namespace tc
@@ -3,21 +3,44 @@
 #include <unordered_set>
 #include <set>
 #include <algorithm>
+#include <stdexcept>
 
 namespace tc{
 
-void TransportCatalogue::AddStop(const std::string& stop_name, geo::Coordinates cords){
-    stops_.push_back({stop_name, cords.lat, cords.lng});
+void TransportCatalogue::Reserve(size_t stop_count, size_t bus_count, size_t distance_count){
+    stopname_to_stop_.reserve(stop_count);
+    stop_buses_.reserve(stop_count);
+    busname_to_bus_.reserve(bus_count);
+    stops_distances_.Reserve(distance_count);
+}
+
+const Stop* TransportCatalogue::AddStop(std::string stop_name, geo::Coordinates cords){
+    stops_.push_back({std::move(stop_name), cords, static_cast<uint32_t>(stops_.size())});
     stopname_to_stop_[stops_.back().stop_name] = &stops_.back();
+    stop_buses_.emplace_back();
+    ++version_;
+    return &stops_.back();
 }
 
-void TransportCatalogue::AddBus(const std::string& bus_name, const std::vector<std::string>& stops, bool is_roundtrip){
-    buses_.push_back({bus_name, stops, is_roundtrip});
-    busname_to_bus_[buses_.back().bus_name] = &buses_.back();
-    for(auto stop_name : stops){
-        auto stop = FindStopByName(stop_name);
-        stops_to_buses_[stop].emplace_back(bus_name);
+const Bus* TransportCatalogue::AddBus(std::string bus_name, std::vector<std::string> stops, bool is_roundtrip){
+    // Имена остановок разрешаются в номера один раз, дальше маршрут хранит только номера
+    const uint32_t stops_begin = static_cast<uint32_t>(bus_stops_.size());
+    for(const auto& stop_name : stops){
+        const Stop* stop = FindStopByName(stop_name);
+        if(!stop){
+            bus_stops_.resize(stops_begin);
+            throw std::invalid_argument("Unknown stop " + stop_name);
+        }
+        bus_stops_.push_back(stop->id);
     }
+    const Bus& bus = buses_.emplace_back(Bus{std::move(bus_name), is_roundtrip, stops_begin,
+                                             static_cast<uint32_t>(stops.size()), static_cast<uint32_t>(buses_.size())});
+    busname_to_bus_[bus.bus_name] = &bus;
+    for(const uint32_t stop_id : GetBusStopIds(bus)){
+        stop_buses_[stop_id].emplace_back(bus.bus_name);
+    }
+    ++version_;
+    return &bus;
 }
 
 const Stop* TransportCatalogue::FindStopByName(std::string_view  stop_name) const{
@@ -30,66 +53,117 @@ const Bus* TransportCatalogue::FindBusByName(std::string_view  bus_name) const {
     return iter != busname_to_bus_.end() ? iter->second : nullptr;
 }
 
+const Stop* TransportCatalogue::GetStopById(uint32_t id) const {
+    return &stops_[id];
+}
+
+size_t TransportCatalogue::GetStopCount() const {
+    return stops_.size();
+}
+
+ranges::Range<const uint32_t*> TransportCatalogue::GetBusStopIds(const Bus& bus) const {
+    const uint32_t* begin = bus_stops_.data() + bus.stops_begin;
+    return {begin, begin + bus.stop_count};
+}
+
+std::vector<std::string_view> TransportCatalogue::GetBusStopNames(const Bus& bus) const {
+    std::vector<std::string_view> names;
+    names.reserve(bus.stop_count);
+    for(const uint32_t stop_id : GetBusStopIds(bus)){
+        names.push_back(stops_[stop_id].stop_name);
+    }
+    return names;
+}
+
+const Stop* TransportCatalogue::FindNearestStop(geo::Coordinates cords) const {
+    const Stop* nearest = nullptr;
+    double min_distance = 0;
+    for (const auto& stop : stops_){
+        const double distance = geo::ComputeDistance(cords, stop.cords);
+        if (!nearest || distance < min_distance){
+            nearest = &stop;
+            min_distance = distance;
+        }
+    }
+    return nearest;
+}
+
 const RouteInformation TransportCatalogue::GetRouteInfo(std::string_view bus_name) const{
-    Bus bus = *FindBusByName(std::string(bus_name));
+    const Bus& bus = *FindBusByName(bus_name);
     double geo_distance = 0;
     int route_distance = 0;
     double curvature = 0;
-    geo::Coordinates cords_from, cords_to;
-    std::unordered_set<std::string_view> unique_stops;
-    for (const auto& bus_stop: bus.stop_names){
-        if(!unique_stops.count(bus_stop)){
-            unique_stops.insert(bus_stop);
-        }
-    }
-    for (auto iter = bus.stop_names.begin(); iter + 1 != bus.stop_names.end(); ++iter){
-        cords_from = {stopname_to_stop_.find(*iter)->second->cords.lat, stopname_to_stop_.find(*iter)->second->cords.lng};
-        cords_to = {stopname_to_stop_.find(*(iter + 1))->second->cords.lat, stopname_to_stop_.find(*(iter + 1))->second->cords.lng};
-        geo_distance += ComputeDistance(cords_from, cords_to);
-        route_distance += GetDistanceBetweenStops(stopname_to_stop_.at(*iter), stopname_to_stop_.at(*(iter + 1)));
+    const auto stop_ids = GetBusStopIds(bus);
+    for (auto iter = stop_ids.begin(); iter + 1 != stop_ids.end(); ++iter){
+        const Stop& stop_from = stops_[*iter];
+        const Stop& stop_to = stops_[*(iter + 1)];
+        geo_distance += ComputeDistance(stop_from.cords, stop_to.cords);
+        route_distance += GetDistanceBetweenStops(&stop_from, &stop_to);
     }
     curvature = route_distance / geo_distance;
-    return {bus.bus_name, bus.stop_names.size(), unique_stops.size(), route_distance, curvature};
+    return {bus.bus_name, bus.stop_count, GetUniqueStopsCount(bus), route_distance, curvature};
 }
 
 const std::set<std::string_view> TransportCatalogue::GetStopInfo(std::string_view stop_name) const{
-    const Stop* stop = FindStopByName(std::string(stop_name));
+    const Stop* stop = FindStopByName(stop_name);
     std::set<std::string_view> unique_buses;
-    auto it = stops_to_buses_.find(stop);
-    if (it != stops_to_buses_.end()){
-        for (const auto& bus_name : it->second){
-            unique_buses.insert(bus_name);
-        }
+    if (stop){
+        unique_buses.insert(stop_buses_[stop->id].begin(), stop_buses_[stop->id].end());
     }
     return unique_buses;
 }
 
 void TransportCatalogue::SetDistanceToStops(const Stop* stop1, const Stop* stop2, int distance){
-    stops_distances_[{stop1,stop2}] = distance;
+    if (!stop1 || !stop2){
+        return;
+    }
+    stops_distances_.Set(GetDistanceKey(stop1, stop2), distance);
+    ++version_;
+}
+
+uint64_t TransportCatalogue::GetVersion() const {
+    return version_;
 }
 
 int TransportCatalogue::GetDistanceBetweenStops(const Stop* stop1, const Stop* stop2) const {
-    return stops_distances_.count({stop1, stop2}) ? stops_distances_.at({stop1,stop2}) : stops_distances_.at({stop2,stop1});
+    if(const int* distance = stops_distances_.Find(GetDistanceKey(stop1, stop2))){
+        return *distance;
+    }
+    if(const int* distance = stops_distances_.Find(GetDistanceKey(stop2, stop1))){
+        return *distance;
+    }
+    throw std::out_of_range("No distance between stops");
 }
 
-size_t TransportCatalogue::GetUniqueStopsCount(std::string_view bus_name) const {
-    std::set<std::string_view> unique_stops;
-    if(!busname_to_bus_.at(bus_name)->stop_names.empty()){
-        for(const auto& stop : busname_to_bus_.at(bus_name)->stop_names){
-            unique_stops.insert(stop);
-        }
+uint64_t TransportCatalogue::GetDistanceKey(const Stop* from, const Stop* to){
+    return (static_cast<uint64_t>(from->id) << 32) | to->id;
+}
+
+void TransportCatalogue::SetBusDepartures(const Bus* bus, std::vector<double> departures){
+    std::sort(departures.begin(), departures.end());
+    if(bus_departures_.size() <= bus->id){
+        bus_departures_.resize(bus->id + 1);
     }
-    return unique_stops.size();
+    bus_departures_[bus->id] = std::move(departures);
+    ++version_;
+}
+
+const std::vector<double>& TransportCatalogue::GetBusDepartures(const Bus* bus) const {
+    static const std::vector<double> no_departures;
+    return bus->id < bus_departures_.size() ? bus_departures_[bus->id] : no_departures;
+}
+
+size_t TransportCatalogue::GetUniqueStopsCount(const Bus& bus) const {
+    const auto stop_ids = GetBusStopIds(bus);
+    std::vector<uint32_t> unique_stops(stop_ids.begin(), stop_ids.end());
+    std::sort(unique_stops.begin(), unique_stops.end());
+    return std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
 }
 
 std::set<std::string_view> TransportCatalogue::GetUniqueBuses(std::string_view stop_name) const {
     std::set<std::string_view> unique_buses;
-    const Stop* stop = FindStopByName(std::string(stop_name));
-    const auto iter = stops_to_buses_.find(stop);
-    if(iter != stops_to_buses_.end() && !iter->second.empty()){
-        for (const auto& bus : iter->second){
-            unique_buses.insert(bus);
-        }
+    if(const Stop* stop = FindStopByName(stop_name)){
+        unique_buses.insert(stop_buses_[stop->id].begin(), stop_buses_[stop->id].end());
     }
     return unique_buses;
 }
@@ -118,14 +192,15 @@ std::deque<Stop> TransportCatalogue::GetAllSortedStops() const{
 }
 
 std::optional<RouteInformation> TransportCatalogue::GetBusStat(std::string_view bus_name) const{
+    const Bus* bus = FindBusByName(bus_name);
     RouteInformation route;
-    route.unique_stops = GetUniqueStopsCount(bus_name);
+    route.unique_stops = GetUniqueStopsCount(*bus);
     double geo_distance = 0;
     int route_distance = 0;
-    const Bus* bus = FindBusByName(std::string(bus_name));
-    for(auto it = bus->stop_names.begin(); it != std::prev(bus->stop_names.end()); ++it){
-        const auto& current_stop = FindStopByName(*it);
-        const auto& next_stop = FindStopByName(*(it+ 1));
+    const auto stop_ids = GetBusStopIds(*bus);
+    for(auto it = stop_ids.begin(); it != std::prev(stop_ids.end()); ++it){
+        const Stop* current_stop = &stops_[*it];
+        const Stop* next_stop = &stops_[*(it + 1)];
         if(bus->is_roundtrip){
             geo_distance += geo::ComputeDistance(current_stop->cords, next_stop->cords);
             route_distance += GetDistanceBetweenStops(current_stop, next_stop);
@@ -136,7 +211,7 @@ std::optional<RouteInformation> TransportCatalogue::GetBusStat(std::string_view
                             + GetDistanceBetweenStops(current_stop, next_stop);
         }
     }
-    route.stops_on_route = bus->is_roundtrip ? bus->stop_names.size() : bus->stop_names.size() * 2 - 1;
+    route.stops_on_route = bus->is_roundtrip ? bus->stop_count : bus->stop_count * 2 - 1;
     route.route_length = route_distance;
     route.curvature = route_distance / geo_distance;
     return route;
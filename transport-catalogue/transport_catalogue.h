@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <deque>
 #include <unordered_map>
@@ -8,19 +9,28 @@
 #include <utility>
 #include <optional>
 
+#include "flat_hash_map.h"
 #include "geo.h"
+#include "ranges.h"
 
 namespace tc{
 	
 struct Stop{
 	std::string stop_name;
 	geo::Coordinates cords;
+	// Номер остановки в порядке добавления в справочник
+	uint32_t id = 0;
 };
 
+// Остановки маршрута хранятся номерами подряд в общем пуле справочника:
+// stops_begin - начало последовательности в пуле, stop_count - её длина
 struct Bus{
 	std::string bus_name;
-	std::vector<std::string> stop_names;
-    bool is_roundtrip;
+	bool is_roundtrip = false;
+	uint32_t stops_begin = 0;
+	uint32_t stop_count = 0;
+	// Номер маршрута в порядке добавления в справочник
+	uint32_t id = 0;
 };
 
 struct RouteInformation{
@@ -31,39 +41,58 @@ struct RouteInformation{
 	double curvature;
 };
 
-struct PtrHasher {
-	size_t operator()(const std::pair<const Stop*, const Stop*>& stops) const{
-		return ptr_hasher(stops.first) + 100 * ptr_hasher(stops.second);
-	}
-private:
-	std::hash<const Stop*> ptr_hasher;
-};
-
 class TransportCatalogue {
 public:
-	void AddStop(const std::string& stop_name, geo::Coordinates cords);
-	void AddBus(const std::string& bus_name, const std::vector<std::string>& stops, bool is_roundtrip);
+	// Резервирует место в индексах справочника перед массовой загрузкой
+	void Reserve(size_t stop_count, size_t bus_count, size_t distance_count);
+	const Stop* AddStop(std::string stop_name, geo::Coordinates cords);
+	const Bus* AddBus(std::string bus_name, std::vector<std::string> stops, bool is_roundtrip);
 	const Stop* FindStopByName(std::string_view stop_name) const;
 	const Bus* FindBusByName(std::string_view  bus_name) const ;
+	const Stop* GetStopById(uint32_t id) const;
+	size_t GetStopCount() const;
+	// Номера остановок маршрута в порядке следования. Диапазон указывает в общий пул
+	// и действителен до следующего вызова AddBus
+	ranges::Range<const uint32_t*> GetBusStopIds(const Bus& bus) const;
+	// Имена остановок маршрута в порядке следования
+	std::vector<std::string_view> GetBusStopNames(const Bus& bus) const;
+	// Ближайшая к точке остановка или nullptr, если остановок нет
+	const Stop* FindNearestStop(geo::Coordinates cords) const;
 	const RouteInformation GetRouteInfo(std::string_view bus_name) const;
 	const std::set<std::string_view> GetStopInfo(std::string_view stop_name) const;
+	// Остановки, которых нет в справочнике (nullptr), пропускаются
 	void SetDistanceToStops(const Stop* stop1, const Stop* stop2, int distance);
 	int GetDistanceBetweenStops(const Stop* stop1, const Stop* stop2) const;
+	// Расписание маршрута: время отправления рейсов с первой остановки в минутах от начала суток
+	void SetBusDepartures(const Bus* bus, std::vector<double> departures);
+	const std::vector<double>& GetBusDepartures(const Bus* bus) const;
 	std::optional<RouteInformation> GetBusStat(std::string_view bus_name) const;
 	std::set<std::string_view> GetUniqueBuses(std::string_view stop_name) const;
 	std::unordered_map<std::string_view, const Bus*> GetBusesMap() const;
 	std::deque<Bus> GetAllSortedBuses() const;
 	std::deque<Stop> GetAllSortedStops() const;
+	// Номер версии справочника, меняется при каждом изменении данных.
+	// По нему кэши ответов узнают, что сохранённые ответы устарели
+	uint64_t GetVersion() const;
 
 
 private:
-	size_t GetUniqueStopsCount(std::string_view bus_name) const;
+	size_t GetUniqueStopsCount(const Bus& bus) const;
+	static uint64_t GetDistanceKey(const Stop* from, const Stop* to);
 
 	std::deque<Bus> buses_;
 	std::deque<Stop> stops_;
 	std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
 	std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
-	std::unordered_map<const Stop*, std::vector<std::string>> stops_to_buses_;
-	std::unordered_map<std::pair<const Stop*, const Stop*>, int, PtrHasher> stops_distances_; 
+	// Номера остановок всех маршрутов подряд, см. Bus
+	std::vector<uint32_t> bus_stops_;
+	// stop_buses_[id] - имена маршрутов, проходящих через остановку с номером id
+	std::vector<std::vector<std::string_view>> stop_buses_;
+	// Расстояния по ключу из номеров остановок отправления и назначения, см. GetDistanceKey
+	flat::U64HashMap<int> stops_distances_;
+	// bus_departures_[id] - расписание маршрута с номером id. По номеру, а не по указателю,
+	// расписание находится и в копии справочника
+	std::vector<std::vector<double>> bus_departures_;
+	uint64_t version_ = 0;
 };
 }
\ No newline at end of file
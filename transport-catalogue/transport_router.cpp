@@ -1,19 +1,11 @@
 #include "transport_router.h"
+#include "metrics.h"
+#include "parallel.h"
 
-namespace tc {
-
-bool RouteWeight::operator<(const RouteWeight& other) const {
-    return this->time < other.time;
-}
-RouteWeight RouteWeight::operator+(const RouteWeight& other) const {
-    RouteWeight result;
-    result.time = this->time + other.time;
-    return result;
-}
-bool RouteWeight::operator>(const RouteWeight& other) const {
-    return !(*this < other);
-}
+#include <algorithm>
+#include <set>
 
+namespace tc {
 
 const RouterSettings& TransportRouter::GetRouterSettings() const{
     return settings_;
@@ -21,43 +13,61 @@ const RouterSettings& TransportRouter::GetRouterSettings() const{
 
 TransportRouter::TransportRouter(const RouterSettings& settings, const TransportCatalogue& catalogue)
                                 : settings_(settings), catalogue_(catalogue){
-    graph::DirectedWeightedGraph<RouteWeight> graph(SetVertexId());
+    graph::DirectedWeightedGraph<double> graph(SetVertexId());
     graph_ = std::move(graph);
-    BuildEdges(catalogue);
-    router_ = std::make_unique<graph::Router<RouteWeight>>(graph_);
+    {
+        TC_METRICS_SCOPE("router_build_edges");
+        BuildEdges(catalogue);
+    }
+    TC_METRICS_COUNT("router_edges", graph_.GetEdgeCount());
+    timetable_ = TimetableRouter(catalogue, settings_.bus_velocity, settings_.max_timetable_rides);
+    pareto_ = std::make_unique<ParetoState>(graph_);
+    if(settings_.route_cache_mb > 0){
+        lazy_router_ = std::make_unique<graph::LazyRouter<double>>(
+            graph_, static_cast<size_t>(settings_.route_cache_mb * 1024 * 1024));
+        return;
+    }
+    TC_METRICS_SCOPE("router_relaxation");
+    router_ = std::make_unique<graph::Router<double>>(graph_);
 }
 
-double TransportRouter::ComputeRouteTime(const Bus& bus, int stop_id_start, int stop_id_dest){
-    double distance = catalogue_.GetDistanceBetweenStops(catalogue_.FindStopByName(bus.stop_names.at(stop_id_start)),
-                                                         catalogue_.FindStopByName(bus.stop_names.at(stop_id_dest)));
+double TransportRouter::ComputeRouteTime(const std::vector<const Stop*>& stops, int stop_id_start, int stop_id_dest){
+    double distance = catalogue_.GetDistanceBetweenStops(stops.at(stop_id_start), stops.at(stop_id_dest));
     return distance / settings_.bus_velocity;
 }
 
-graph::Edge<RouteWeight> TransportRouter::ConstructEdge(const Bus& bus, size_t stop_id_start, size_t stop_id_dest){
-    graph::Edge<RouteWeight> edge;
-    edge.from = stop_vertex_.at(bus.stop_names.at(stop_id_start));
-    edge.to = stop_vertex_.at(bus.stop_names.at(stop_id_dest));
-    edge.weight.bus_name = bus.bus_name;
-    edge.weight.stop_count = stop_id_dest - stop_id_start;
+graph::Edge<double> TransportRouter::ConstructEdge(const Bus& bus, const std::vector<const Stop*>& stops,
+                                                   size_t stop_id_start, size_t stop_id_dest){
+    graph::Edge<double> edge;
+    edge.from = stop_id_vertex_[stops.at(stop_id_start)->id];
+    edge.to = stop_id_vertex_[stops.at(stop_id_dest)->id];
+    edge_info_.push_back({bus.bus_name, static_cast<int>(stop_id_dest - stop_id_start)});
     return edge;
 }
 
-void TransportRouter::AddEdge(const Bus& bus, int direction_factor, int stop_id_start, int stop_id_dest, double& total_time){
-    graph::Edge<RouteWeight> edge = ConstructEdge(bus, stop_id_start, stop_id_dest);
-    total_time += ComputeRouteTime(bus, stop_id_dest + direction_factor, stop_id_dest);
-    edge.weight.time = total_time;
+void TransportRouter::AddEdge(const Bus& bus, const std::vector<const Stop*>& stops, int direction_factor,
+                              int stop_id_start, int stop_id_dest, double& total_time){
+    graph::Edge<double> edge = ConstructEdge(bus, stops, stop_id_start, stop_id_dest);
+    total_time += ComputeRouteTime(stops, stop_id_dest + direction_factor, stop_id_dest);
+    edge.weight = total_time;
     graph_.AddEdge(edge);
 }
 void TransportRouter::BuildEdges(const TransportCatalogue& catalogue){
+    // Остановки маршрута берутся по номерам один раз на маршрут, без поиска по именам
+    std::vector<const Stop*> stops;
     for (const auto& bus : catalogue.GetAllSortedBuses()){
-        int stops_count = bus.stop_names.size();
+        stops.clear();
+        for (const uint32_t stop_id : catalogue.GetBusStopIds(bus)){
+            stops.push_back(catalogue.GetStopById(stop_id));
+        }
+        int stops_count = stops.size();
         for (size_t i = 0; i != stops_count - 1; ++i){
             double forward_time = settings_.bus_wait_time;
             double back_time = settings_.bus_wait_time;
             for(size_t j = i + 1; j < stops_count; ++j){
-                AddEdge(bus, -1, i, j, forward_time);
+                AddEdge(bus, stops, -1, i, j, forward_time);
                 if(!bus.is_roundtrip){
-                    AddEdge(bus, 1, stops_count - 1 - i, stops_count - 1 - j, back_time);
+                    AddEdge(bus, stops, 1, stops_count - 1 - i, stops_count - 1 - j, back_time);
                 }
             }
         }
@@ -68,10 +78,12 @@ graph::VertexId TransportRouter::SetVertexId(){
     const std::deque<Stop> all_stops = catalogue_.GetAllSortedStops();
     stop_vertex_.reserve(all_stops.size());
     vertex_stop_.reserve(all_stops.size());
+    stop_id_vertex_.resize(all_stops.size());
     size_t count = 0;
     for(const auto& stop : all_stops){
         stop_vertex_.insert({stop.stop_name, count});
         vertex_stop_.insert({count, stop.stop_name});
+        stop_id_vertex_[stop.id] = count;
         ++count;
     }
     return count;
@@ -82,19 +94,261 @@ TransportRouter::BuildRoute(const std::string& start, const std::string& end) co
     if(start == end){
         std::vector<RouterEdge>{};
     }
-    std::optional<graph::Router<RouteWeight>::RouteInfo> route = router_->BuildRoute(stop_vertex_.at(start), stop_vertex_.at(end));
-    if (!route.has_value()){
+    const graph::VertexId from = stop_vertex_.at(start);
+    const graph::VertexId to = stop_vertex_.at(end);
+    return WithRouter([&](const auto& router) -> std::optional<std::vector<RouterEdge>>{
+        const auto route = router.BuildRoute(from, to);
+        if (!route.has_value()){
+            return std::nullopt;
+        }
+        return GetRouterEdges(route->edges);
+    });
+}
+
+const std::optional<std::vector<RouterEdge>>
+TransportRouter::BuildRoute(const std::string& start, const std::string& end, double departure_time) const {
+    if(!timetable_.HasSchedules()){
+        return BuildRoute(start, end);
+    }
+    const auto legs = timetable_.BuildRoute(start, end, departure_time);
+    if(!legs.has_value()){
         return std::nullopt;
     }
     std::vector<RouterEdge> edges;
-    for(auto& id : route->edges){
-        const graph::Edge<RouteWeight>& edge = graph_.GetEdge(id);
+    edges.reserve(legs->size());
+    for(const auto& leg : *legs){
+        RouterEdge route_edge;
+        route_edge.bus = leg.bus;
+        route_edge.start_stop = leg.start_stop;
+        route_edge.dest_stop = leg.dest_stop;
+        route_edge.stop_count = leg.stop_count;
+        route_edge.time = leg.wait_time + leg.ride_time;
+        route_edge.wait_time = leg.wait_time;
+        edges.push_back(std::move(route_edge));
+    }
+    return edges;
+}
+
+std::vector<std::optional<std::vector<RouterEdge>>>
+TransportRouter::BuildRoutes(const std::string& start, const std::vector<std::string>& ends) const {
+    std::vector<graph::VertexId> targets;
+    targets.reserve(ends.size());
+    for(const auto& end : ends){
+        targets.push_back(stop_vertex_.at(end));
+    }
+    const graph::VertexId from = stop_vertex_.at(start);
+    return WithRouter([&](const auto& router){
+        std::vector<std::optional<std::vector<RouterEdge>>> result;
+        result.reserve(ends.size());
+        for(const auto& route : router.BuildRoutes(from, targets)){
+            if (!route.has_value()){
+                result.emplace_back(std::nullopt);
+            }
+            else{
+                result.emplace_back(GetRouterEdges(route->edges));
+            }
+        }
+        return result;
+    });
+}
+
+std::vector<RouteOption> TransportRouter::BuildParetoRoutes(const std::string& start, const std::string& end) const {
+    const graph::VertexId from = stop_vertex_.at(start);
+    const graph::VertexId to = stop_vertex_.at(end);
+    std::lock_guard lock(pareto_->mutex);
+    std::vector<RouteOption> options;
+    for(const auto& path : pareto_->search.Run(from, to)){
+        options.push_back(MakeRouteOption(path));
+    }
+    return options;
+}
+
+std::vector<RouteOption> TransportRouter::BuildAlternativeRoutes(const std::string& start, const std::string& end,
+                                                                 size_t max_count) const {
+    // Алгоритм Йена: очередной маршрут ищется среди ответвлений от каждой остановки предыдущего.
+    // Все поиски идут через один ShortestPathSearch и общие массивы запретов,
+    // которые после каждого поиска сбрасываются только в изменённых позициях
+    const graph::VertexId from = stop_vertex_.at(start);
+    const graph::VertexId to = stop_vertex_.at(end);
+    std::vector<RouteOption> options;
+    if(max_count == 0){
+        return options;
+    }
+    if(from == to){
+        options.emplace_back();
+        return options;
+    }
+    graph::ShortestPathSearch<double> search(graph_);
+    auto path_time = [this](const std::vector<graph::EdgeId>& path){
+        double time = 0;
+        for(const graph::EdgeId id : path){
+            time += graph_.GetEdge(id).weight;
+        }
+        return time;
+    };
+
+    search.Run(from, to, [](graph::EdgeId){
+        return false;
+    });
+    if(!search.IsReached(to)){
+        return options;
+    }
+    std::vector<std::vector<graph::EdgeId>> found{search.GetRouteEdges(to)};
+    std::set<std::pair<double, std::vector<graph::EdgeId>>> candidates;
+    std::vector<bool> blocked_edges(graph_.GetEdgeCount(), false);
+    std::vector<bool> blocked_vertices(graph_.GetVertexCount(), false);
+    std::vector<graph::EdgeId> blocked_edge_list;
+    std::vector<graph::EdgeId> root;
+
+    while(found.size() < max_count){
+        const std::vector<graph::EdgeId>& last = found.back();
+        root.clear();
+        graph::VertexId spur = from;
+        for(size_t i = 0; i < last.size(); ++i){
+            // Запрещаются продолжения общего корня, уже использованные найденными маршрутами,
+            // и остановки корня, чтобы маршрут не проходил через них повторно
+            for(const auto& path : found){
+                if(path.size() > i && std::equal(root.begin(), root.end(), path.begin()) && !blocked_edges[path[i]]){
+                    blocked_edges[path[i]] = true;
+                    blocked_edge_list.push_back(path[i]);
+                }
+            }
+            blocked_vertices[spur] = true;
+            search.Run(spur, to, [&](graph::EdgeId id){
+                return blocked_edges[id] || blocked_vertices[graph_.GetEdge(id).to];
+            });
+            if(search.IsReached(to)){
+                std::vector<graph::EdgeId> path = root;
+                const std::vector<graph::EdgeId> spur_path = search.GetRouteEdges(to);
+                path.insert(path.end(), spur_path.begin(), spur_path.end());
+                const double time = path_time(path);
+                candidates.insert({time, std::move(path)});
+            }
+            for(const graph::EdgeId id : blocked_edge_list){
+                blocked_edges[id] = false;
+            }
+            blocked_edge_list.clear();
+
+            root.push_back(last[i]);
+            spur = graph_.GetEdge(last[i]).to;
+        }
+        for(const graph::EdgeId id : root){
+            blocked_vertices[graph_.GetEdge(id).from] = false;
+        }
+        if(candidates.empty()){
+            break;
+        }
+        found.push_back(std::move(candidates.begin()->second));
+        candidates.erase(candidates.begin());
+    }
+
+    options.reserve(found.size());
+    for(const auto& path : found){
+        options.push_back(MakeRouteOption(path));
+    }
+    return options;
+}
+
+size_t TransportRouter::SelectPreferredOption(const std::vector<RouteOption>& options) const {
+    // Варианты упорядочены по числу пересадок, поэтому при равенстве остаётся вариант с меньшим их числом
+    auto cost = [this](const RouteOption& option){
+        return option.total_time + settings_.transfer_penalty * option.transfer_count;
+    };
+    size_t best = 0;
+    for(size_t i = 1; i < options.size(); ++i){
+        if(cost(options[i]) < cost(options[best])){
+            best = i;
+        }
+    }
+    return best;
+}
+
+TravelTimeMatrix TransportRouter::GetTravelTimes(const std::vector<std::string>& starts, const std::vector<std::string>& ends,
+                                                 bool with_transfers) const {
+    // Строк в куске столько, чтобы в нём набиралось хотя бы несколько тысяч ячеек
+    const size_t min_rows = std::max<size_t>(1, 4096 / std::max<size_t>(1, ends.size()));
+    std::vector<graph::VertexId> targets;
+    targets.reserve(ends.size());
+    for(const auto& end : ends){
+        targets.push_back(stop_vertex_.at(end));
+    }
+    std::vector<graph::VertexId> sources;
+    sources.reserve(starts.size());
+    for(const auto& start : starts){
+        sources.push_back(stop_vertex_.at(start));
+    }
+
+    TravelTimeMatrix matrix;
+    matrix.rows = starts.size();
+    matrix.cols = ends.size();
+    matrix.times.resize(matrix.rows * matrix.cols);
+    if(with_transfers){
+        matrix.transfers.resize(matrix.rows * matrix.cols, 0);
+    }
+    // Строки матрицы независимы и заполняются параллельно
+    par::ForEachChunk(sources.size(), min_rows, [&](size_t, size_t begin, size_t end){
+        WithRouter([&](const auto& router){
+            for(size_t row = begin; row < end; ++row){
+                const auto summaries = router.GetRouteSummaries(sources[row], targets);
+                for(size_t col = 0; col < targets.size(); ++col){
+                    if(!summaries[col].has_value()){
+                        continue;
+                    }
+                    const size_t cell = row * matrix.cols + col;
+                    matrix.times[cell] = summaries[col]->weight;
+                    if(with_transfers && summaries[col]->edge_count > 0){
+                        matrix.transfers[cell] = static_cast<int>(summaries[col]->edge_count) - 1;
+                    }
+                }
+            }
+        });
+    });
+    return matrix;
+}
+
+graph::RouteTreeCacheStats TransportRouter::GetRouteCacheStats() const {
+    if(!lazy_router_){
+        return {};
+    }
+    return lazy_router_->GetStats();
+}
+
+std::vector<ReachableStop> TransportRouter::GetReachableStops(const std::string& start, double max_time) const {
+    // Ограниченный поиск по графу маршрутов прекращается, как только ближайшая
+    // нерассмотренная остановка оказывается дальше max_time
+    graph::ShortestPathSearch<double> search(graph_);
+    search.Run(stop_vertex_.at(start), max_time);
+    std::vector<ReachableStop> stops;
+    stops.reserve(search.GetSettledVertices().size());
+    for(const graph::VertexId vertex : search.GetSettledVertices()){
+        stops.push_back({vertex_stop_.at(vertex), search.GetWeight(vertex)});
+    }
+    return stops;
+}
+
+RouteOption TransportRouter::MakeRouteOption(const std::vector<graph::EdgeId>& route) const {
+    RouteOption option;
+    option.edges = GetRouterEdges(route);
+    option.transfer_count = std::max(0, static_cast<int>(route.size()) - 1);
+    for(const auto& edge : option.edges){
+        option.total_time += edge.time;
+    }
+    return option;
+}
+
+std::vector<RouterEdge> TransportRouter::GetRouterEdges(const std::vector<graph::EdgeId>& route) const {
+    std::vector<RouterEdge> edges;
+    edges.reserve(route.size());
+    for(auto& id : route){
+        const graph::Edge<double>& edge = graph_.GetEdge(id);
+        const RouteEdgeInfo& info = edge_info_[id];
         RouterEdge route_edge;
-        route_edge.bus = edge.weight.bus_name;
+        route_edge.bus = info.bus_name;
         route_edge.start_stop = vertex_stop_.at(edge.from);
         route_edge.dest_stop = vertex_stop_.at(edge.to);
-        route_edge.stop_count = edge.weight.stop_count;
-        route_edge.time = edge.weight.time;
+        route_edge.stop_count = info.stop_count;
+        route_edge.time = edge.weight;
+        route_edge.wait_time = settings_.bus_wait_time;
         edges.push_back(route_edge);
     }
     return edges;
@@ -1,17 +1,20 @@
 #pragma once
 
+#include "dijkstra.h"
+#include "lazy_router.h"
+#include "pareto_search.h"
 #include "router.h"
+#include "timetable_router.h"
 #include "transport_catalogue.h"
 #include <memory>
+#include <mutex>
 namespace tc{
 
-struct RouteWeight{
+// Автобус и число пролётов для ребра графа маршрутов. Вес самого ребра в графе -
+// время в пути в минутах, поэтому таблица маршрутов хранит только числа
+struct RouteEdgeInfo{
     std::string bus_name;
     int stop_count = 0;
-    double time = 0;
-    bool operator<(const RouteWeight& other) const;
-	bool operator>(const RouteWeight& other) const;
-	RouteWeight operator+(const RouteWeight& other) const;
 };
 
 struct RouterEdge{
@@ -19,12 +22,46 @@ struct RouterEdge{
     std::string start_stop;
     std::string dest_stop;
     int stop_count = 0;
+    // Полное время поездки, включая ожидание автобуса wait_time
     double time = 0;
+    double wait_time = 0;
+};
+
+// Матрица времени в пути между остановками отправления (строки) и прибытия (столбцы).
+// Ячейки хранятся подряд по строкам, недостижимым парам соответствует std::nullopt
+struct TravelTimeMatrix{
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<std::optional<double>> times;
+    // Число пересадок, заполняется по запросу
+    std::vector<int> transfers;
+};
+
+// Остановка, достижимая из заданной, и время прибытия на неё в минутах
+struct ReachableStop{
+    std::string_view stop_name;
+    double time = 0;
+};
+
+// Вариант маршрута, не уступающий другим одновременно по времени и по числу пересадок
+struct RouteOption{
+    double total_time = 0;
+    int transfer_count = 0;
+    std::vector<RouterEdge> edges;
 };
 
 struct RouterSettings{
     int bus_wait_time = 1;
     double bus_velocity = 1.0;
+    // Штраф в минутах за каждую пересадку. Им выбирается предпочтительный вариант
+    // в ответе на запрос вариантов маршрута, обычные маршруты он не меняет
+    double transfer_penalty = 0;
+    // Ограничение памяти под кэш деревьев маршрутов в мегабайтах. Если оно задано, таблица
+    // всех пар не строится, а деревья из остановок отправления считаются по первому запросу
+    double route_cache_mb = 0;
+    // Наибольшее число рейсов в маршруте по расписанию. Маршруты, которым нужно больше
+    // рейсов, не находятся
+    size_t max_timetable_rides = TimetableRouter::DEFAULT_MAX_RIDES;
 };
 
 class TransportRouter{
@@ -37,16 +74,64 @@ public:
     const RouterSettings& GetRouterSettings() const;
     const std::optional<std::vector<RouterEdge>>
     BuildRoute(const std::string& start, const std::string& end) const;
+    // Маршрут по расписаниям рейсов с отправлением не раньше departure_time (в минутах от начала суток).
+    // Если расписаний нет, строится обычный маршрут с фиксированным временем ожидания
+    const std::optional<std::vector<RouterEdge>>
+    BuildRoute(const std::string& start, const std::string& end, double departure_time) const;
+    // Маршруты из start в каждую из остановок ends, в том же порядке
+    std::vector<std::optional<std::vector<RouterEdge>>>
+    BuildRoutes(const std::string& start, const std::vector<std::string>& ends) const;
+    // Все остановки, до которых из start можно добраться не дольше чем за max_time минут,
+    // в порядке возрастания времени прибытия
+    std::vector<ReachableStop> GetReachableStops(const std::string& start, double max_time) const;
+    // Варианты маршрута из start в end, не доминируемые по времени и числу пересадок,
+    // в порядке возрастания числа пересадок
+    std::vector<RouteOption> BuildParetoRoutes(const std::string& start, const std::string& end) const;
+    // До max_count различных маршрутов из start в end без повторных остановок
+    // в порядке возрастания времени, первым идёт кратчайший
+    std::vector<RouteOption> BuildAlternativeRoutes(const std::string& start, const std::string& end,
+                                                    size_t max_count) const;
+    // Индекс варианта с наименьшим временем с учётом штрафа за пересадки, options не должен быть пуст
+    size_t SelectPreferredOption(const std::vector<RouteOption>& options) const;
+    TravelTimeMatrix GetTravelTimes(const std::vector<std::string>& starts, const std::vector<std::string>& ends,
+                                    bool with_transfers) const;
+    // Статистика кэша деревьев маршрутов, нулевая, если кэш не используется
+    graph::RouteTreeCacheStats GetRouteCacheStats() const;
 private:
+    // Вызывает func с тем маршрутизатором, который построен: с таблицей всех пар или с кэшем деревьев
+    template <typename Func>
+    decltype(auto) WithRouter(Func func) const{
+        if(lazy_router_){
+            return func(*lazy_router_);
+        }
+        return func(*router_);
+    }
+    std::vector<RouterEdge> GetRouterEdges(const std::vector<graph::EdgeId>& route) const;
+    RouteOption MakeRouteOption(const std::vector<graph::EdgeId>& route) const;
     void BuildEdges(const TransportCatalogue& catalogue);
-    graph::Edge<RouteWeight> ConstructEdge(const Bus& bus, size_t stop_id_start, size_t stop_id_dest);
-    void AddEdge(const Bus& bus, int direction_factor, int stop_id_start, int stop_id_dest, double& total_time);
-	double ComputeRouteTime(const Bus& bus, int stop_id_start, int stop_id_dest);
+    graph::Edge<double> ConstructEdge(const Bus& bus, const std::vector<const Stop*>& stops,
+                                      size_t stop_id_start, size_t stop_id_dest);
+    void AddEdge(const Bus& bus, const std::vector<const Stop*>& stops, int direction_factor,
+                 int stop_id_start, int stop_id_dest, double& total_time);
+	double ComputeRouteTime(const std::vector<const Stop*>& stops, int stop_id_start, int stop_id_dest);
     graph::VertexId SetVertexId();
-    graph::DirectedWeightedGraph<RouteWeight> graph_;
-    std::unique_ptr<graph::Router<RouteWeight>> router_ = nullptr;
+    graph::DirectedWeightedGraph<double> graph_;
+    // edge_info_[id] описывает ребро графа с идентификатором id
+    std::vector<RouteEdgeInfo> edge_info_;
+    std::unique_ptr<graph::Router<double>> router_ = nullptr;
+    std::unique_ptr<graph::LazyRouter<double>> lazy_router_ = nullptr;
+    // Поиск вариантов маршрута с рабочими массивами, общими для всех запросов
+    struct ParetoState{
+        explicit ParetoState(const graph::DirectedWeightedGraph<double>& graph) : search(graph){}
+        std::mutex mutex;
+        graph::ParetoSearch<double> search;
+    };
+    std::unique_ptr<ParetoState> pareto_ = nullptr;
+    TimetableRouter timetable_;
     std::unordered_map<std::string, size_t> stop_vertex_;
     std::unordered_map<graph::VertexId, std::string> vertex_stop_;
+    // stop_id_vertex_[Stop::id] - вершина графа для остановки
+    std::vector<graph::VertexId> stop_id_vertex_;
     RouterSettings settings_;
     TransportCatalogue catalogue_;
 };